@@ -0,0 +1,109 @@
+#include "Bench.h"
+
+#ifdef WIKI_BENCH
+
+#include <M5Cardputer.h>
+#include "TextLayout.h"
+#include "Arial.h"
+#include "SearchBench.h"
+#include "FrameBench.h"
+
+static const char* BENCH_TEXT =
+    "Apple Inc. is an American multinational technology company headquartered in "
+    "Cupertino, California, that designs, develops, and sells consumer electronics, "
+    "computer software, and online services.\n"
+    "Apple was founded by Steve Jobs, Steve Wozniak, and Ronald Wayne in April 1976.\n"
+    "Москва - столица России, город федерального значения, административный центр "
+    "Центрального федерального округа и центр Московской области, в состав которой не входит.\n"
+    "Население в пределах городской черты составляет более тринадцати миллионов человек.";
+
+static uint32_t countGlyphs(const char* s, uint32_t len) {
+    uint32_t n = 0;
+    for (uint32_t i = 0; i < len; i++) {
+        if ((s[i] & 0xC0) != 0x80) n++; // Count UTF-8 lead bytes
+    }
+    return n;
+}
+
+void benchRender() {
+    M5Canvas canvas(&M5Cardputer.Display);
+    canvas.setColorDepth(16);
+    if (!canvas.createSprite(240, 135)) {
+        Serial.println("bench: no memory for canvas");
+        return;
+    }
+    canvas.setFont(&Arial6pt16b);
+    canvas.setTextColor(WHITE);
+    canvas.setTextWrap(false);
+
+    TextLayout layout;
+    layout.setFont(&Arial6pt16b);
+    layout.layout(BENCH_TEXT, strlen(BENCH_TEXT), 232);
+
+    uint32_t lines = layout.lineCount();
+    uint32_t glyphsPerPass = 0;
+    for (uint32_t l = 0; l < lines; l++) glyphsPerPass += countGlyphs(layout.lineText(l), layout.lineLength(l));
+
+    const int passes = 50;
+
+    // Before: one print() per line, LovyanGFX decodes and draws each glyph
+    unsigned long t0 = micros();
+    for (int p = 0; p < passes; p++) {
+        canvas.fillScreen(BLACK);
+        for (uint32_t l = 0; l < lines; l++) {
+            canvas.setCursor(0, (l % 11) * layout.lineHeight());
+            canvas.write((const uint8_t*)layout.lineText(l), layout.lineLength(l));
+        }
+    }
+    unsigned long printUs = micros() - t0;
+
+    // After: batch decode + blit through the glyph map
+    t0 = micros();
+    for (int p = 0; p < passes; p++) {
+        canvas.fillScreen(BLACK);
+        canvas.startWrite();
+        for (uint32_t l = 0; l < lines; l++) {
+            layout.drawRun(canvas, 0, (l % 11) * layout.lineHeight(),
+                           layout.lineText(l), layout.lineLength(l), WHITE);
+        }
+        canvas.endWrite();
+    }
+    unsigned long runUs = micros() - t0;
+
+    // Blank frames, to subtract the fillScreen cost
+    t0 = micros();
+    for (int p = 0; p < passes; p++) canvas.fillScreen(BLACK);
+    unsigned long clearUs = micros() - t0;
+
+    uint64_t glyphs = (uint64_t)glyphsPerPass * passes;
+    unsigned long printNet = printUs > clearUs ? printUs - clearUs : 1;
+    unsigned long runNet = runUs > clearUs ? runUs - clearUs : 1;
+
+    Serial.printf("bench render: %u glyphs x %d passes\n", glyphsPerPass, passes);
+    Serial.printf("  print():   %lu us, %lu glyphs/s\n", printNet, (unsigned long)(glyphs * 1000000ULL / printNet));
+    Serial.printf("  drawRun(): %lu us, %lu glyphs/s\n", runNet, (unsigned long)(glyphs * 1000000ULL / runNet));
+
+    canvas.deleteSprite();
+}
+
+void benchSearch(WikiEngine& engine) {
+    SdLatencyModel sd; // The card is real here
+    for (int t = 0; t < SEARCH_TRACE_COUNT; t++) {
+        SearchBenchReport r = benchSearchTrace(engine, SEARCH_TRACES[t], 100, sd);
+        char line[256];
+        formatSearchReport(r, engine.getEntryCount(), line, sizeof(line));
+        Serial.println(line);
+    }
+}
+
+void benchScreens(WikiEngine& engine, UI& ui) {
+    FrameBenchReport r = benchFrames(engine, ui, 20);
+    Serial.printf("bench frames: %u articles, %u failed to load\n", r.articles, r.failed);
+    for (int k = 0; k < FRAME_KINDS; k++) {
+        char line[128];
+        formatFrameReport(r, k, line, sizeof(line));
+        Serial.println(line);
+    }
+}
+
+#endif
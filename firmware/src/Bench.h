@@ -0,0 +1,22 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+// On-device benchmarks, built only in the m5stack-cardputer-bench env
+// (-DWIKI_BENCH). Results are printed over serial.
+#ifdef WIKI_BENCH
+
+class WikiEngine;
+class UI;
+
+// Glyphs per second: LovyanGFX print() vs TextLayout::drawRun()
+void benchRender();
+
+// Keystroke trace replay against the card's index (see SearchBench.h)
+void benchSearch(WikiEngine& engine);
+
+// Frame time and bytes pushed per screen and scroll step (see FrameBench.h)
+void benchScreens(WikiEngine& engine, UI& ui);
+
+#endif
+
+#endif
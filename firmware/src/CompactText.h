@@ -0,0 +1,22 @@
+#ifndef COMPACT_TEXT_H
+#define COMPACT_TEXT_H
+
+// Compact single-byte article encoding (converter.py --encoding compact).
+// Keep in sync with converter.py.
+//
+//   [COMPACT_MARKER][0x80 | window]  header, window = base codepoint >> 7
+//   0x09, 0x0A, 0x20..0x7E           ASCII as is
+//   0x80..0xFF                       codepoint (window << 7) + (byte - 0x80)
+//   [COMPACT_QUOTE][b2][b1][b0]      any other codepoint, 7 bits per byte,
+//                                    each payload byte has the top bit set
+//
+// Payload bytes never fall in the ASCII range, so byte-oriented passes like
+// cleanWikiText() can run over compact text unchanged.
+#define COMPACT_MARKER 0x0E
+#define COMPACT_QUOTE 0x02
+
+inline bool isCompactText(const char* text) {
+    return text && (unsigned char)text[0] == COMPACT_MARKER && ((unsigned char)text[1] & 0x80);
+}
+
+#endif
@@ -0,0 +1,119 @@
+#include "FrameBench.h"
+
+#ifdef WIKI_BENCH
+
+#include "WikiText.h"
+
+static const char* const FRAME_KIND_NAMES[FRAME_KINDS] = {
+    "search-key", "search-results", "results-open", "results-move",
+    "reader-open", "reader-line", "reader-page", "reader-jump",
+};
+
+// Frames per article and screen
+#define SEARCH_KEYS 8
+#define RESULT_MOVES 8
+#define LINE_STEPS 12
+#define PAGE_STEPS 6
+
+static void record(FrameBenchReport& r, FrameKind kind, UI& ui) {
+    const UI::FrameStats& f = ui.getFrameStats();
+    FrameKindStats& k = r.kinds[kind];
+    k.frames++;
+    k.totalUs += f.lastUs;
+    if (f.lastUs > k.maxUs) k.maxUs = f.lastUs;
+    k.bytes += (uint64_t)f.lastPixels * FRAME_BYTES_PER_PIXEL;
+}
+
+// Types the first SEARCH_KEYS codepoints of the title, each key followed
+// by its results, as the search screen draws them
+static void searchFrames(FrameBenchReport& r, WikiEngine& engine, UI& ui, const char* title) {
+    ui.setSearchQuery("");
+    ui.setResults(std::vector<String>());
+    ui.setState(STATE_SEARCH);
+
+    String query;
+    const char* p = title;
+    for (int key = 0; key < SEARCH_KEYS && *p; key++) {
+        do {
+            query += String(*p++);
+        } while ((*p & 0xC0) == 0x80);
+
+        ui.setSearchQuery(query);
+        ui.draw();
+        record(r, FRAME_SEARCH_KEY, ui);
+
+        ui.setResults(engine.search(query, 100));
+        ui.draw();
+        record(r, FRAME_SEARCH_RESULTS, ui);
+    }
+}
+
+static void readerFrames(FrameBenchReport& r, UI& ui) {
+    ui.setState(STATE_READING);
+    record(r, FRAME_READER_OPEN, ui);
+
+    int page = ui.getReaderPageLines();
+    for (int i = 0; i < LINE_STEPS; i++) {
+        ui.scrollReader(1);
+        record(r, FRAME_READER_LINE, ui);
+    }
+    for (int i = 0; i < PAGE_STEPS; i++) {
+        ui.scrollReader(page - 1);
+        record(r, FRAME_READER_PAGE, ui);
+    }
+    // Towards the end and back to the top (both clamp on short articles)
+    ui.scrollReader(page * 8);
+    record(r, FRAME_READER_JUMP, ui);
+    ui.scrollReader(-page * 16);
+    record(r, FRAME_READER_JUMP, ui);
+}
+
+FrameBenchReport benchFrames(WikiEngine& engine, UI& ui, uint32_t articles) {
+    FrameBenchReport r;
+    uint32_t total = engine.getEntryCount();
+    if (articles > total) articles = total;
+
+    for (uint32_t n = 0; n < articles; n++) {
+        WikiIndexEntry entry;
+        if (!engine.getEntry((uint64_t)n * total / articles, &entry)) break;
+        entry.title[TITLE_LIMIT - 1] = 0;
+        r.articles++;
+
+        searchFrames(r, engine, ui, entry.title);
+
+        if (ui.getResult(0).length() > 0) {
+            ui.setState(STATE_RESULTS);
+            record(r, FRAME_RESULTS_OPEN, ui);
+            for (int i = 0; i < RESULT_MOVES; i++) {
+                ui.moveSelection(1);
+                record(r, FRAME_RESULTS_MOVE, ui);
+            }
+        }
+
+        // Same steps as opening it from the results screen
+        engine.loadArticleAt(entry.offset, entry.length, ui.getArticleBuffer(), ui.getArticleBufferSize());
+        if (!engine.getLastOpen().ok) {
+            r.failed++;
+            continue;
+        }
+        cleanWikiText(ui.getArticleBuffer());
+        ui.setArticleTitle(String(entry.title));
+        ui.setArticleText(ui.getArticleBuffer());
+        readerFrames(r, ui);
+    }
+
+    ui.setSearchQuery("");
+    ui.setResults(std::vector<String>());
+    ui.setState(STATE_SEARCH);
+    return r;
+}
+
+void formatFrameReport(const FrameBenchReport& r, int kind, char* out, size_t outLen) {
+    const FrameKindStats& k = r.kinds[kind];
+    uint32_t frames = k.frames ? k.frames : 1;
+    snprintf(out, outLen, "bench frames %-14s frames=%u avg=%uus max=%uus bytes/frame=%u",
+             FRAME_KIND_NAMES[kind], k.frames, (unsigned)(k.totalUs / frames), k.maxUs,
+             (unsigned)(k.bytes / frames));
+}
+
+#endif
@@ -0,0 +1,50 @@
+#ifndef FRAME_BENCH_H
+#define FRAME_BENCH_H
+
+// Rendering benchmark, shared by the device bench env and the native env
+// (both define WIKI_BENCH). Drives the search, results and reader screens
+// of a UI over articles spread across the index, the way the keys do, and
+// times every draw() with the UI's FrameStats. On the device the frames go
+// to the panel; on the host into the framebuffer of src/native/NativeGfx.h.
+#ifdef WIKI_BENCH
+
+#include "WikiEngine.h"
+#include "UI.h"
+
+enum FrameKind {
+    FRAME_SEARCH_KEY,     // Keystroke, old results still listed
+    FRAME_SEARCH_RESULTS, // Results for the new query arrive
+    FRAME_RESULTS_OPEN,   // Results screen entered
+    FRAME_RESULTS_MOVE,   // Selection moved one row
+    FRAME_READER_OPEN,    // First paint of an article
+    FRAME_READER_LINE,    // Scrolled one line (held key)
+    FRAME_READER_PAGE,    // Scrolled a page minus one line ('.' / tab)
+    FRAME_READER_JUMP,    // Scrolled further than a page: full redraw
+    FRAME_KINDS
+};
+
+struct FrameKindStats {
+    uint32_t frames = 0;
+    uint64_t totalUs = 0;
+    uint32_t maxUs = 0;
+    uint64_t bytes = 0; // Pushed to the panel
+};
+
+struct FrameBenchReport {
+    uint32_t articles = 0;
+    uint32_t failed = 0; // Articles the engine could not load
+    FrameKindStats kinds[FRAME_KINDS];
+};
+
+// The panel takes RGB565 whatever the canvas depth
+#define FRAME_BYTES_PER_PIXEL 2
+
+// Leaves the UI on an empty search screen. 'ui' must have had begin().
+FrameBenchReport benchFrames(WikiEngine& engine, UI& ui, uint32_t articles);
+
+// One line per frame kind: frames, mean / max time, bytes pushed per frame
+void formatFrameReport(const FrameBenchReport& r, int kind, char* out, size_t outLen);
+
+#endif
+
+#endif
@@ -0,0 +1,16 @@
+#include "Latency.h"
+#include <algorithm>
+
+void LatencyWindow::add(uint32_t us) {
+    _samples[_total++ % LATENCY_WINDOW] = us;
+}
+
+uint32_t LatencyWindow::percentile(int pct) const {
+    uint32_t n = count();
+    if (n == 0) return 0;
+
+    uint32_t sorted[LATENCY_WINDOW];
+    std::copy(_samples, _samples + n, sorted);
+    std::sort(sorted, sorted + n);
+    return sorted[(n - 1) * pct / 100];
+}
@@ -0,0 +1,26 @@
+#ifndef LATENCY_H
+#define LATENCY_H
+
+// Rolling window of the last LATENCY_WINDOW samples of one user-facing
+// latency, with percentiles over the window. Shown on the diagnostics
+// screen and sent over serial with 'l'.
+
+#include <stdint.h>
+
+#define LATENCY_WINDOW 32
+
+class LatencyWindow {
+public:
+    void add(uint32_t us);
+    uint32_t count() const { return _total < LATENCY_WINDOW ? _total : LATENCY_WINDOW; }
+    uint32_t total() const { return _total; }  // Samples ever taken
+    uint32_t last() const { return _total ? _samples[(_total - 1) % LATENCY_WINDOW] : 0; }
+    // 'pct' in 0..100 over the window, 0 when empty
+    uint32_t percentile(int pct) const;
+
+private:
+    uint32_t _samples[LATENCY_WINDOW];
+    uint32_t _total = 0;
+};
+
+#endif
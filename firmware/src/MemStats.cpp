@@ -0,0 +1,92 @@
+#include "MemStats.h"
+#include <Arduino.h>
+#include <atomic>
+#include <stdio.h>
+
+static const char* const SUBSYSTEM_NAMES[MEM_SUBSYSTEMS] = {
+    "article buf", "canvas", "layout", "results", "article in", "unzip stack", "dict",
+};
+
+struct SubsystemStats {
+    std::atomic<uint32_t> live{0};
+    std::atomic<uint32_t> peak{0};
+    std::atomic<uint32_t> allocs{0};
+    std::atomic<uint32_t> frees{0};
+};
+
+struct HeapSample {
+    uint32_t ms;
+    uint32_t freeHeap;
+    uint32_t largest;
+    uint32_t freePsram;
+};
+
+static SubsystemStats subsystems[MEM_SUBSYSTEMS];
+
+// Only memSample() writes these, from the UI loop
+static HeapSample history[MEM_HISTORY];
+static uint32_t historyCount = 0;
+static uint32_t warnThreshold = MEM_WARN_LARGEST_BLOCK;
+static bool belowThreshold = false;
+
+void memAlloc(MemSubsystem sub, size_t bytes) {
+    SubsystemStats& s = subsystems[sub];
+    uint32_t live = s.live.fetch_add(bytes) + bytes;
+    uint32_t peak = s.peak.load();
+    while (live > peak && !s.peak.compare_exchange_weak(peak, live)) {}
+    s.allocs++;
+}
+
+void memFree(MemSubsystem sub, size_t bytes) {
+    SubsystemStats& s = subsystems[sub];
+    s.live -= bytes;
+    s.frees++;
+}
+
+void memSetWarnThreshold(uint32_t largestBlockBytes) {
+    warnThreshold = largestBlockBytes;
+    belowThreshold = false;
+}
+
+bool memSample() {
+    HeapSample& h = history[historyCount++ % MEM_HISTORY];
+    h.ms = millis();
+    h.freeHeap = ESP.getFreeHeap();
+    h.largest = ESP.getMaxAllocHeap();
+    h.freePsram = ESP.getFreePsram();
+
+    // Warn once per dip; the host shims report 0 and never warn
+    bool below = h.freeHeap > 0 && h.largest < warnThreshold;
+    bool crossed = below && !belowThreshold;
+    belowThreshold = below;
+    return crossed;
+}
+
+void memDump(void (*emit)(const char* line)) {
+    char line[96];
+
+    emit("# mem subsystems: live / peak bytes, allocs / frees");
+    for (int i = 0; i < MEM_SUBSYSTEMS; i++) {
+        const SubsystemStats& s = subsystems[i];
+        snprintf(line, sizeof(line), "%-12s %7u %7u %6u %6u", SUBSYSTEM_NAMES[i],
+                 (unsigned)s.live.load(), (unsigned)s.peak.load(),
+                 (unsigned)s.allocs.load(), (unsigned)s.frees.load());
+        emit(line);
+    }
+
+    snprintf(line, sizeof(line), "# mem heap now %u free, %u largest, %u min ever; psram %u / %u free",
+             (unsigned)ESP.getFreeHeap(), (unsigned)ESP.getMaxAllocHeap(), (unsigned)ESP.getMinFreeHeap(),
+             (unsigned)ESP.getFreePsram(), (unsigned)ESP.getPsramSize());
+    emit(line);
+
+    // Fragmentation: share of the free heap not usable by one allocation
+    emit("# mem history: ms, free, largest, frag %, psram free");
+    uint32_t count = historyCount < MEM_HISTORY ? historyCount : MEM_HISTORY;
+    for (uint32_t i = historyCount - count; i != historyCount; i++) {
+        const HeapSample& h = history[i % MEM_HISTORY];
+        unsigned frag = h.freeHeap ? 100 - (unsigned)((uint64_t)h.largest * 100 / h.freeHeap) : 0;
+        snprintf(line, sizeof(line), "%10u %7u %7u %3u %7u", (unsigned)h.ms, (unsigned)h.freeHeap,
+                 (unsigned)h.largest, frag, (unsigned)h.freePsram);
+        emit(line);
+    }
+}
@@ -0,0 +1,40 @@
+#ifndef MEM_STATS_H
+#define MEM_STATS_H
+
+// Heap telemetry: live bytes and allocation counts for the big allocations
+// of each subsystem, plus a history of free heap / largest free block so
+// fragmentation over a long session shows up before it ends in an OOM.
+// Send 'm' over serial to dump it, 'w<KB>' to set the warning threshold.
+
+#include <stdint.h>
+#include <stddef.h>
+
+enum MemSubsystem : uint8_t {
+    MEM_ARTICLE_BUFFER, // UI article buffer (VIEW_BUF_SIZE)
+    MEM_CANVAS,         // Off-screen sprite
+    MEM_LAYOUT,         // Line table of the wrapped article
+    MEM_RESULTS,        // Result titles held by the UI
+    MEM_ARTICLE_INPUT,  // Compressed blob, when it is not decoded in place
+    MEM_UNZIP_TASK,     // Stack of the inflate task
+    MEM_DICT,           // Preset dictionary and its inflate window
+    MEM_SUBSYSTEMS
+};
+
+// Call around each tracked allocation. Safe from any task.
+void memAlloc(MemSubsystem sub, size_t bytes);
+void memFree(MemSubsystem sub, size_t bytes);
+
+// Default: a large compressed article that cannot be decoded in place
+// (the unzip task and its window are allocated once, at boot)
+#define MEM_WARN_LARGEST_BLOCK (48 * 1024)
+
+// Samples the heap into the history ring (MEM_HISTORY entries). Returns
+// true when the largest free block has just dropped below the threshold.
+#define MEM_HISTORY 64
+bool memSample();
+void memSetWarnThreshold(uint32_t largestBlockBytes);
+
+// Subsystem table, then the history, oldest first; one line per call
+void memDump(void (*emit)(const char* line));
+
+#endif
@@ -0,0 +1,101 @@
+#include "SearchBench.h"
+
+#ifdef WIKI_BENCH
+
+#include <algorithm>
+#include <vector>
+
+static const char* const TRACE_LATIN[] = {
+    "Albert Einstein",
+    "Apple Inc.",
+    "Berlin",
+    "Computer science",
+    "London Underground",
+    "Python (programming language)",
+    "Sherlock Holmes",
+    "World War II",
+    "Zebra",
+};
+
+static const char* const TRACE_CYRILLIC[] = {
+    "Москва",
+    "Пушкин, Александр Сергеевич",
+    "Россия",
+    "Санкт-Петербург",
+    "Великая Отечественная война",
+    "Чехов, Антон Павлович",
+    "Ёж",
+    "Яблоко",
+};
+
+const SearchTrace SEARCH_TRACES[] = {
+    { "latin", TRACE_LATIN, sizeof(TRACE_LATIN) / sizeof(TRACE_LATIN[0]) },
+    { "cyrillic", TRACE_CYRILLIC, sizeof(TRACE_CYRILLIC) / sizeof(TRACE_CYRILLIC[0]) },
+};
+const int SEARCH_TRACE_COUNT = sizeof(SEARCH_TRACES) / sizeof(SEARCH_TRACES[0]);
+
+uint32_t SdLatencyModel::costUs(const WikiEngine::IoStats& io) const {
+    uint64_t us = (uint64_t)io.seeks * seekUs + (uint64_t)io.reads * readUs;
+    if (bytesPerMs) us += io.bytes * 1000 / bytesPerMs;
+    return (uint32_t)us;
+}
+
+SearchBenchReport benchSearchTrace(WikiEngine& engine, const SearchTrace& trace, int limit,
+                                   const SdLatencyModel& sd) {
+    SearchBenchReport r;
+    r.trace = trace.name;
+
+    std::vector<uint32_t> latencies;
+    uint64_t seeks = 0, reads = 0, bytes = 0;
+
+    for (int e = 0; e < trace.count; e++) {
+        const char* entry = trace.entries[e];
+        size_t len = strlen(entry);
+        for (size_t end = 1; end <= len; end++) {
+            // Whole codepoints only: stop at lead bytes
+            if (end < len && (entry[end] & 0xC0) == 0x80) continue;
+
+            char query[128];
+            size_t n = end < sizeof(query) - 1 ? end : sizeof(query) - 1;
+            memcpy(query, entry, n);
+            query[n] = 0;
+
+            engine.resetIoStats();
+            unsigned long t0 = micros();
+            std::vector<String> results = engine.search(String(query), limit);
+            uint32_t us = micros() - t0;
+
+            const WikiEngine::IoStats& io = engine.getIoStats();
+            us += sd.costUs(io);
+            latencies.push_back(us);
+            seeks += io.seeks;
+            reads += io.reads;
+            bytes += io.bytes;
+            r.totalUs += us;
+            r.results += results.size();
+        }
+    }
+
+    r.queries = latencies.size();
+    if (r.queries == 0) return r;
+
+    std::sort(latencies.begin(), latencies.end());
+    r.p50Us = latencies[(r.queries - 1) * 50 / 100];
+    r.p99Us = latencies[(r.queries - 1) * 99 / 100];
+    r.maxUs = latencies.back();
+    r.seeksPerQuery = (float)seeks / r.queries;
+    r.readsPerQuery = (float)reads / r.queries;
+    r.bytesPerQuery = (float)bytes / r.queries;
+    r.resultsPerSec = r.totalUs ? r.results * 1e6f / r.totalUs : 0;
+    return r;
+}
+
+void formatSearchReport(const SearchBenchReport& r, uint32_t entries, char* out, size_t outLen) {
+    snprintf(out, outLen,
+             "bench search %-8s entries=%u queries=%u p50=%uus p99=%uus max=%uus "
+             "seeks/q=%.1f reads/q=%.1f bytes/q=%.0f results/s=%.0f",
+             r.trace, entries, r.queries, r.p50Us, r.p99Us, r.maxUs,
+             r.seeksPerQuery, r.readsPerQuery, r.bytesPerQuery, r.resultsPerSec);
+}
+
+#endif
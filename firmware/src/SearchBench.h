@@ -0,0 +1,53 @@
+#ifndef SEARCH_BENCH_H
+#define SEARCH_BENCH_H
+
+// Search latency benchmark, shared by the device bench env and the native
+// env (both define WIKI_BENCH). Replays keystroke traces against whatever
+// index the engine has open.
+#ifdef WIKI_BENCH
+
+#include "WikiEngine.h"
+
+// SD card cost model for the host, where the "card" is the page cache.
+// All zero on the device, where the card is real.
+struct SdLatencyModel {
+    uint32_t seekUs = 0;
+    uint32_t readUs = 0;      // Fixed cost per read call
+    uint32_t bytesPerMs = 0;  // Transfer rate, 0 = free
+    uint32_t costUs(const WikiEngine::IoStats& io) const;
+};
+
+struct SearchBenchReport {
+    const char* trace;
+    uint32_t queries = 0;
+    uint32_t results = 0;
+    uint32_t p50Us = 0;
+    uint32_t p99Us = 0;
+    uint32_t maxUs = 0;
+    uint64_t totalUs = 0;
+    float seeksPerQuery = 0;
+    float readsPerQuery = 0;
+    float bytesPerQuery = 0;
+    float resultsPerSec = 0;
+};
+
+struct SearchTrace {
+    const char* name;
+    const char* const* entries; // Each entry is typed one codepoint at a time
+    int count;
+};
+
+extern const SearchTrace SEARCH_TRACES[];
+extern const int SEARCH_TRACE_COUNT;
+
+// Every prefix of every entry is one query, the way the search screen issues
+// them while typing. 'limit' matches the search worker (100).
+SearchBenchReport benchSearchTrace(WikiEngine& engine, const SearchTrace& trace, int limit,
+                                   const SdLatencyModel& sd);
+
+// One line: trace, entries, latency percentiles and SD traffic per query
+void formatSearchReport(const SearchBenchReport& r, uint32_t entries, char* out, size_t outLen);
+
+#endif
+
+#endif
@@ -0,0 +1,193 @@
+#include "TextLayout.h"
+#include "GlyphMap.h"
+#include "CompactText.h"
+
+// Decodes one UTF-8 sequence at text[i] and advances i past it
+static uint32_t nextCodepoint(const char* text, uint32_t& i, uint32_t len) {
+    unsigned char c = static_cast<unsigned char>(text[i++]);
+    if (c < 0x80) return c;
+
+    int extra;
+    uint32_t cp;
+    if ((c & 0xE0) == 0xC0) { extra = 1; cp = c & 0x1F; }
+    else if ((c & 0xF0) == 0xE0) { extra = 2; cp = c & 0x0F; }
+    else if ((c & 0xF8) == 0xF0) { extra = 3; cp = c & 0x07; }
+    else return 0xFFFD;
+
+    while (extra-- > 0 && i < len) {
+        cp = (cp << 6) | (static_cast<unsigned char>(text[i++]) & 0x3F);
+    }
+    return cp;
+}
+
+void TextLayout::setFont(const GFXfont* font) {
+    _font = font;
+}
+
+int TextLayout::lineHeight() const {
+    return _font ? _font->yAdvance : 8;
+}
+
+// All glyphs of one 128-codepoint window, or null if the font has none
+static const uint16_t* compactWindowMap(uint8_t window) {
+    uint32_t base = (uint32_t)window << 7;
+    if (base >= 0x400 && base < 0x500) return GLYPH_MAP_CYRILLIC + (base - 0x400);
+    return nullptr;
+}
+
+uint16_t TextLayout::nextGlyph(const char* text, uint32_t& i, uint32_t len) const {
+    if (!_compact) return glyphIndexFor(nextCodepoint(text, i, len));
+
+    // Compact text: the byte is the glyph, no UTF-8 decoding
+    unsigned char b = static_cast<unsigned char>(text[i++]);
+    if (b >= 0x80) return _windowMap ? _windowMap[b - 0x80] : GLYPH_NONE;
+    if (b != COMPACT_QUOTE) return GLYPH_MAP_LATIN[b];
+
+    uint32_t cp = 0;
+    for (int k = 0; k < 3 && i < len; k++) {
+        cp = (cp << 7) | (static_cast<unsigned char>(text[i++]) & 0x7F);
+    }
+    return glyphIndexFor(cp);
+}
+
+int TextLayout::glyphAdvance(uint16_t glyph) const {
+    if (!_font) return 6; // Built-in 6x8 font
+    if (glyph == GLYPH_NONE) return 0;
+    return _font->glyph[glyph].xAdvance;
+}
+
+int TextLayout::drawRun(LovyanGFX& gfx, int x, int y, const char* text, uint32_t len, uint16_t color) const {
+    const uint8_t* bitmap = _font->bitmap;
+    int baseline = y + GLYPH_BASELINE;
+
+    uint32_t i = 0;
+    while (i < len) {
+        uint16_t gi = nextGlyph(text, i, len);
+        if (gi == GLYPH_NONE) continue;
+
+        const GFXglyph& g = _font->glyph[gi];
+        const uint8_t* bits = bitmap + g.bitmapOffset;
+        int gx = x + g.xOffset;
+        int gy = baseline + g.yOffset;
+
+        // Glyph bits are packed MSB first, rows run on without padding.
+        // Emit one horizontal span per run of set bits.
+        uint8_t byte = 0;
+        uint8_t mask = 0;
+        for (int row = 0; row < g.height; row++) {
+            int runStart = -1;
+            for (int col = 0; col < g.width; col++) {
+                if (!mask) { byte = *bits++; mask = 0x80; }
+                bool on = byte & mask;
+                mask >>= 1;
+
+                if (on) {
+                    if (runStart < 0) runStart = col;
+                } else if (runStart >= 0) {
+                    gfx.writeFastHLine(gx + runStart, gy + row, col - runStart, color);
+                    runStart = -1;
+                }
+            }
+            if (runStart >= 0) gfx.writeFastHLine(gx + runStart, gy + row, g.width - runStart, color);
+        }
+        x += g.xAdvance;
+    }
+    return x;
+}
+
+void TextLayout::clear() {
+    _text = nullptr;
+    _len = 0;
+    _lineStarts.clear();
+    _compact = false;
+    _windowMap = nullptr;
+}
+
+void TextLayout::layout(const char* text, uint32_t len, int maxWidth) {
+    clear();
+    if (!text || len == 0) return;
+
+    _text = text;
+    _len = len;
+
+    uint32_t lineStart = 0;
+    if (len >= 2 && isCompactText(text)) {
+        _compact = true;
+        _windowMap = compactWindowMap(text[1] & 0x7F);
+        lineStart = 2; // Skip the header
+    }
+    _lineStarts.push_back(lineStart);
+
+    uint32_t breakAt = 0;   // Offset just past the last space on this line
+    int width = 0;
+    int widthAtBreak = 0;
+
+    uint32_t i = lineStart;
+    while (i < len) {
+        char c = text[i];
+
+        if (c == '\n') {
+            i++;
+            if (i < len) _lineStarts.push_back(i);
+            lineStart = i;
+            breakAt = 0;
+            width = 0;
+            continue;
+        }
+
+        uint32_t charStart = i;
+        int adv = glyphAdvance(nextGlyph(text, i, len));
+
+        if (width + adv > maxWidth && charStart > lineStart) {
+            if (c == ' ') {
+                // Overflowing space: swallow it and start fresh
+                lineStart = i;
+                width = 0;
+                breakAt = 0;
+                if (i < len) _lineStarts.push_back(lineStart);
+                continue;
+            }
+            if (breakAt > lineStart) {
+                // Word wrap: the tail after the last space moves down
+                lineStart = breakAt;
+                width -= widthAtBreak;
+            } else {
+                // One long word, hard break
+                lineStart = charStart;
+                width = 0;
+            }
+            breakAt = 0;
+            _lineStarts.push_back(lineStart);
+        }
+
+        width += adv;
+        if (c == ' ') {
+            breakAt = i;
+            widthAtBreak = width;
+        }
+    }
+}
+
+const char* TextLayout::lineText(uint32_t line) const {
+    if (line >= _lineStarts.size()) return nullptr;
+    return _text + _lineStarts[line];
+}
+
+uint32_t TextLayout::lineLength(uint32_t line) const {
+    if (line >= _lineStarts.size()) return 0;
+    uint32_t start = _lineStarts[line];
+    uint32_t end = (line + 1 < _lineStarts.size()) ? _lineStarts[line + 1] : _len;
+    while (end > start && (_text[end - 1] == '\n' || _text[end - 1] == ' ')) end--;
+    return end - start;
+}
+
+void TextLayout::drawLines(LovyanGFX& gfx, uint32_t first, uint32_t count, int x, int y, uint16_t color) {
+    int lh = lineHeight();
+    gfx.startWrite();
+    for (uint32_t line = first; line < first + count && line < _lineStarts.size(); line++) {
+        uint32_t n = lineLength(line);
+        if (n > 0) drawRun(gfx, x, y, lineText(line), n, color);
+        y += lh;
+    }
+    gfx.endWrite();
+}
@@ -0,0 +1,50 @@
+#ifndef TEXT_LAYOUT_H
+#define TEXT_LAYOUT_H
+
+#include <M5Cardputer.h>
+#include <vector>
+
+// Word-wraps an article once and keeps the start offset of every line,
+// so the reader only has to draw the lines inside the viewport.
+class TextLayout {
+public:
+    // Glyphs are looked up through GlyphMap.h, so this must be Arial6pt16b
+    void setFont(const GFXfont* font);
+
+    // Wraps 'len' bytes of 'text' to 'maxWidth' pixels. The text must stay
+    // alive (and unchanged) for as long as the layout is used.
+    // Accepts UTF-8 or compact single-byte text (see CompactText.h).
+    void layout(const char* text, uint32_t len, int maxWidth);
+    void clear();
+
+    uint32_t lineCount() const { return _lineStarts.size(); }
+    // Heap held by the line table; clear() keeps it for the next article
+    size_t memoryUsed() const { return _lineStarts.capacity() * sizeof(uint32_t); }
+    int lineHeight() const;
+
+    // Byte range of a line, without its trailing newline/space
+    const char* lineText(uint32_t line) const;
+    uint32_t lineLength(uint32_t line) const;
+
+    // Draws lines [first, first + count) starting at (x, y)
+    void drawLines(LovyanGFX& gfx, uint32_t first, uint32_t count, int x, int y, uint16_t color);
+
+    // Decodes and blits a whole run of text in one go (no per-glyph
+    // print() round trip). 'y' is the top of the line. Returns the end x.
+    int drawRun(LovyanGFX& gfx, int x, int y, const char* text, uint32_t len, uint16_t color) const;
+
+private:
+    const GFXfont* _font = nullptr;
+    const char* _text = nullptr;
+    uint32_t _len = 0;
+    std::vector<uint32_t> _lineStarts;
+
+    // Compact text: glyph indices for bytes 0x80..0xFF, null for UTF-8
+    const uint16_t* _windowMap = nullptr;
+    bool _compact = false;
+
+    uint16_t nextGlyph(const char* text, uint32_t& i, uint32_t len) const;
+    int glyphAdvance(uint16_t glyph) const;
+};
+
+#endif
@@ -0,0 +1,51 @@
+#include "Trace.h"
+
+#ifdef WIKI_TRACE
+
+#include <Arduino.h>
+#include <atomic>
+
+// Slots are claimed with one atomic add, so a task preempted mid-write on
+// the same core cannot be handed the same slot. A dump taken while events
+// are still coming in may print a half-written one.
+struct TraceRing {
+    std::atomic<uint32_t> head{0};
+    TraceEvent events[TRACE_RING_SIZE];
+};
+
+static TraceRing rings[portNUM_PROCESSORS];
+
+void traceRecord(const char* name, uint32_t startUs, uint32_t durUs) {
+    TraceRing& ring = rings[xPortGetCoreID()];
+    uint32_t slot = ring.head.fetch_add(1, std::memory_order_relaxed) % TRACE_RING_SIZE;
+
+    TraceEvent& ev = ring.events[slot];
+    ev.startUs = startUs;
+    ev.durUs = durUs;
+    ev.name = name;
+    strncpy(ev.task, pcTaskGetName(NULL), sizeof(ev.task) - 1);
+    ev.task[sizeof(ev.task) - 1] = 0;
+}
+
+void traceDump(Print& out) {
+    out.printf("# trace begin %lu\n", (unsigned long)micros());
+    for (int core = 0; core < portNUM_PROCESSORS; core++) {
+        TraceRing& ring = rings[core];
+        uint32_t head = ring.head.load(std::memory_order_relaxed);
+        uint32_t count = head < TRACE_RING_SIZE ? head : TRACE_RING_SIZE;
+
+        for (uint32_t i = head - count; i != head; i++) {
+            const TraceEvent& ev = ring.events[i % TRACE_RING_SIZE];
+            out.printf("%d %u %u %s %s\n", core, ev.startUs, ev.durUs, ev.task, ev.name);
+        }
+    }
+    out.printf("# trace end\n");
+}
+
+TraceScope::TraceScope(const char* name) : _name(name), _start(micros()) {}
+
+TraceScope::~TraceScope() {
+    traceRecord(_name, _start, micros() - _start);
+}
+
+#endif
@@ -0,0 +1,54 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+// Scoped timing events for seeing how the UI loop, the search worker and
+// the unzip task overlap on the two cores. Built only with -DWIKI_TRACE
+// (m5stack-cardputer-trace env); otherwise every macro expands to nothing.
+//
+//   void UI::draw(...) { TRACE_SCOPE("draw"); ... }
+//
+// Each core writes to its own ring of the last TRACE_RING_SIZE events, so
+// a task never waits on the other core. Send 't' over serial to dump them,
+// tools/trace_to_chrome.py turns the dump into Chrome trace / Perfetto JSON.
+#ifdef WIKI_TRACE
+
+#include <stdint.h>
+#include <Print.h>
+
+#define TRACE_RING_SIZE 256
+
+// One finished scope. 'name' must be a string literal.
+struct TraceEvent {
+    uint32_t startUs;
+    uint32_t durUs;
+    const char* name;
+    char task[12]; // FreeRTOS task name, truncated
+};
+
+void traceRecord(const char* name, uint32_t startUs, uint32_t durUs);
+
+// Prints both rings between "# trace begin" / "# trace end" markers,
+// one "<core> <start us> <duration us> <task> <name>" line per event
+void traceDump(Print& out);
+
+class TraceScope {
+public:
+    explicit TraceScope(const char* name);
+    ~TraceScope();
+
+private:
+    const char* _name;
+    uint32_t _start;
+};
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+#define TRACE_SCOPE(name) TraceScope TRACE_CONCAT(_traceScope, __LINE__)(name)
+
+#else
+
+#define TRACE_SCOPE(name) do {} while (0)
+
+#endif
+
+#endif
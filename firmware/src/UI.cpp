@@ -1,5 +1,14 @@
 #include "UI.h"
 #include "Arial.h"
+#include "Trace.h"
+#include "MemStats.h"
+
+// Heap behind a result list: the vector plus each String's buffer
+static size_t resultsMemory(const std::vector<String>& results) {
+    size_t bytes = results.capacity() * sizeof(String);
+    for (const String& r : results) bytes += r.length() + 1;
+    return bytes;
+}
 
 // ASCII Art for Splash (Simpler, cleaner font)
 const char* ascii_art[] = {
@@ -19,7 +28,7 @@ const char* logo_art[] = {
     "    \\/\\/    |_| |_|\\_\\|_|"
 };
 
-UI::UI() {
+UI::UI() : _canvas(&M5Cardputer.Display) {
     _currentState = STATE_SPLASH;
     _searchQuery = "";
     _selectedResultIndex = 0;
@@ -39,7 +48,25 @@ void UI::begin() {
             M5Cardputer.Display.println("OOM: UI Buffer");
             while(1);
         }
+        memAlloc(MEM_ARTICLE_BUFFER, VIEW_BUF_SIZE);
+    }
+    
+    // Off-screen canvas (16bpp = 64KB). Fall back to 8bpp, then to
+    // drawing straight on the panel if the heap is too tight.
+    _canvas.setColorDepth(16);
+    if (!_canvas.createSprite(SCREEN_W, SCREEN_H)) {
+        _canvas.setColorDepth(8);
+        if (!_canvas.createSprite(SCREEN_W, SCREEN_H)) {
+            _gfx = &M5Cardputer.Display;
+        }
+    }
+    if (!_gfx) {
+        _gfx = &_canvas;
+        memAlloc(MEM_CANVAS, _canvas.bufferLength());
     }
+    _gfx->setTextSize(1);
+    _gfx->setTextColor(WHITE);
+    _dirtyCount = 0;
     
     _articleBuffer[0] = 0; 
     _articleLen = 0;
@@ -48,10 +75,6 @@ void UI::begin() {
 }
 
 void UI::setState(AppState newState) {
-    _currentState = newState;
-    M5Cardputer.Display.fillScreen(BLACK); // Clear on state change
-    M5Cardputer.Display.setFont(&Arial6pt16b);
-
     if (newState == STATE_SEARCH) {
         // Keep query? 
     } else if (newState == STATE_RESULTS) {
@@ -59,7 +82,17 @@ void UI::setState(AppState newState) {
     } else if (newState == STATE_READING) {
         _scrollPosition = 0;
     }
-    
+
+    restoreState(newState);
+}
+
+void UI::restoreState(AppState state) {
+    _currentState = state;
+    _gfx->fillScreen(BLACK); // Clear on state change
+    _gfx->setFont(&Arial6pt16b);
+    _resultsDrawn = false;
+    _readerDrawnLine = -1;
+
     draw(true); // Immediate redraw
 }
 
@@ -77,7 +110,10 @@ String UI::getSearchQuery() {
 
 void UI::setResults(std::vector<String> results) {
     if (_uiMutex) xSemaphoreTake(_uiMutex, portMAX_DELAY);
+    memFree(MEM_RESULTS, resultsMemory(_searchResults));
     _searchResults = results;
+    memAlloc(MEM_RESULTS, resultsMemory(_searchResults));
+    _resultsDrawn = false;
     if (_uiMutex) xSemaphoreGive(_uiMutex);
 }
 
@@ -109,9 +145,24 @@ uint32_t UI::getArticleBufferSize() {
 
 void UI::setArticleText(const char* text) {
     if (_articleBuffer) {
-        strncpy(_articleBuffer, text, VIEW_BUF_SIZE - 1);
-        _articleBuffer[VIEW_BUF_SIZE - 1] = 0;
+        // Engine usually writes straight into our buffer
+        if (text != _articleBuffer) {
+            strncpy(_articleBuffer, text, VIEW_BUF_SIZE - 1);
+            _articleBuffer[VIEW_BUF_SIZE - 1] = 0;
+        }
         _articleLen = strlen(_articleBuffer);
+        
+        // Wrap once here, drawReader only walks the visible lines
+        TRACE_SCOPE("layout");
+        size_t lineTable = _layout.memoryUsed();
+        _layout.setFont(&Arial6pt16b);
+        _layout.layout(_articleBuffer, _articleLen, READER_TEXT_W);
+        if (_layout.memoryUsed() != lineTable) {
+            // The line table grew (it never shrinks)
+            memFree(MEM_LAYOUT, lineTable);
+            memAlloc(MEM_LAYOUT, _layout.memoryUsed());
+        }
+        _readerDrawnLine = -1;
     }
 }
 
@@ -119,6 +170,25 @@ void UI::setArticleTitle(String title) {
     _articleTitle = title;
 }
 
+void UI::setOpenHud(const String& text) {
+    _openHud = text;
+    if (_currentState == STATE_READING && _showOpenHud) {
+        // Just the HUD rectangle, not a reader frame
+        drawStatusBar();
+        flush();
+    }
+}
+
+void UI::toggleOpenHud() {
+    _showOpenHud = !_showOpenHud;
+    _readerDrawnLine = -1; // The title bar is only drawn on a full redraw
+    if (_currentState == STATE_READING) draw(false);
+}
+
+void UI::setDiagnostics(const String& text) {
+    _diagnostics = text;
+}
+
 void UI::moveSelection(int delta) {
     if (_currentState == STATE_RESULTS) {
         if (_uiMutex) xSemaphoreTake(_uiMutex, portMAX_DELAY);
@@ -131,9 +201,17 @@ void UI::moveSelection(int delta) {
     }
 }
 
+int UI::getReaderPageLines() {
+    return READER_H / _layout.lineHeight();
+}
+
 void UI::scrollReader(int delta) {
     if (_currentState == STATE_READING) {
+        int maxLine = (int)_layout.lineCount() - getReaderPageLines();
+        if (maxLine < 0) maxLine = 0;
+        
         _scrollPosition += delta;
+        if (_scrollPosition > maxLine) _scrollPosition = maxLine;
         if (_scrollPosition < 0) _scrollPosition = 0;
         draw(false);
     }
@@ -149,194 +227,336 @@ void UI::update() {
 }
 
 void UI::draw(bool fullRedraw) {
+    TRACE_SCOPE("draw");
+    unsigned long start = micros();
+    
     switch (_currentState) {
         case STATE_SPLASH: drawSplash(); break;
         case STATE_MAIN_MENU: drawMainMenu(); break;
         case STATE_SEARCH: drawSearch(fullRedraw); break;
-        case STATE_RESULTS: drawResults(); break;
+        case STATE_RESULTS: drawResults(fullRedraw); break;
         case STATE_READING: drawReader(); break;
         case STATE_ABOUT: drawAbout(); break;
+        case STATE_DIAGNOSTICS: drawDiagnostics(); break;
     }
     drawStatusBar();
+    flush();
+    
+    _frameStats.lastUs = micros() - start;
+    _frameStats.avgUs = _frameStats.frames ? (_frameStats.avgUs * 7 + _frameStats.lastUs) / 8 : _frameStats.lastUs;
+    if (_frameStats.lastUs > _frameStats.maxUs) _frameStats.maxUs = _frameStats.lastUs;
+    _frameStats.frames++;
+}
+
+const UI::FrameStats& UI::getFrameStats() {
+    return _frameStats;
+}
+
+void UI::markDirty(int x, int y, int w, int h) {
+    // Clip to screen
+    if (x < 0) { w += x; x = 0; }
+    if (y < 0) { h += y; y = 0; }
+    if (x + w > SCREEN_W) w = SCREEN_W - x;
+    if (y + h > SCREEN_H) h = SCREEN_H - y;
+    if (w <= 0 || h <= 0) return;
+    
+    // Already covered?
+    for (int i = 0; i < _dirtyCount; i++) {
+        DirtyRect& r = _dirty[i];
+        if (x >= r.x && y >= r.y && x + w <= r.x + r.w && y + h <= r.y + r.h) return;
+    }
+    
+    if (_dirtyCount == MAX_DIRTY) {
+        // Out of slots: collapse everything into one bounding box
+        int x0 = x, y0 = y, x1 = x + w, y1 = y + h;
+        for (int i = 0; i < _dirtyCount; i++) {
+            DirtyRect& r = _dirty[i];
+            if (r.x < x0) x0 = r.x;
+            if (r.y < y0) y0 = r.y;
+            if (r.x + r.w > x1) x1 = r.x + r.w;
+            if (r.y + r.h > y1) y1 = r.y + r.h;
+        }
+        _dirtyCount = 0;
+        x = x0; y = y0; w = x1 - x0; h = y1 - y0;
+    }
+    _dirty[_dirtyCount++] = {(int16_t)x, (int16_t)y, (int16_t)w, (int16_t)h};
+}
+
+void UI::flush() {
+    TRACE_SCOPE("flush");
+    uint32_t pixels = 0;
+    
+    if (_gfx == &_canvas) {
+        // pushSprite honours the panel clip rect, so only dirty areas go over SPI
+        for (int i = 0; i < _dirtyCount; i++) {
+            DirtyRect& r = _dirty[i];
+            M5Cardputer.Display.setClipRect(r.x, r.y, r.w, r.h);
+            _canvas.pushSprite(0, 0);
+            pixels += r.w * r.h;
+        }
+        M5Cardputer.Display.clearClipRect();
+    }
+    
+    _frameStats.lastPixels = pixels;
+    _dirtyCount = 0;
 }
 
 void UI::drawStatusBar() {
-    // Optional
+    if (_currentState != STATE_READING || !_showOpenHud) return;
+    
+    _gfx->fillRect(HUD_X, 0, SCREEN_W - HUD_X, 25, DARKGREY);
+    _gfx->setFont(NULL);
+    _gfx->setTextColor(YELLOW);
+    
+    int row = 0;
+    int start = 0;
+    while (row < HUD_ROWS && start < (int)_openHud.length()) {
+        int end = _openHud.indexOf('\n', start);
+        if (end < 0) end = _openHud.length();
+        _gfx->setCursor(HUD_X, 1 + row * 8);
+        _gfx->print(_openHud.substring(start, end));
+        start = end + 1;
+        row++;
+    }
+    
+    _gfx->setFont(&Arial6pt16b);
+    markDirty(HUD_X, 0, SCREEN_W - HUD_X, 25);
 }
 
 void UI::drawSplash() {
-    M5Cardputer.Display.fillScreen(BLACK);
-    M5Cardputer.Display.setTextSize(1); 
-    M5Cardputer.Display.setFont(NULL);
+    _gfx->fillScreen(BLACK);
+    markDirty(0, 0, SCREEN_W, SCREEN_H);
+    _gfx->setTextSize(1); 
+    _gfx->setFont(NULL);
 
     int y = 30;
     for (int i=0; i<5; i++) {
-        M5Cardputer.Display.setCursor(40, y + (i*10));
+        _gfx->setCursor(40, y + (i*10));
         
         int scanRow = (_animFrame / 2) % 8; 
         if (i == scanRow || i == scanRow-1) {
-            M5Cardputer.Display.setTextColor(GREEN);
+            _gfx->setTextColor(GREEN);
         } else {
-            M5Cardputer.Display.setTextColor(DARKGREY);
+            _gfx->setTextColor(DARKGREY);
         }
         
         if (_animFrame > i*5) {
-            M5Cardputer.Display.println(logo_art[i]); 
+            _gfx->println(logo_art[i]); 
         }
     }
     
     if (_animFrame > 10) {
-        M5Cardputer.Display.setTextSize(2); 
-        M5Cardputer.Display.setCursor(90, 85); 
-        M5Cardputer.Display.setTextColor(WHITE);
-        M5Cardputer.Display.println("puter");
+        _gfx->setTextSize(2); 
+        _gfx->setCursor(90, 85); 
+        _gfx->setTextColor(WHITE);
+        _gfx->println("puter");
         
-        M5Cardputer.Display.setTextSize(1);
-        M5Cardputer.Display.setCursor(75, 120); 
-        M5Cardputer.Display.setTextColor(LIGHTGREY);
-        M5Cardputer.Display.print("AR://WEAVEFRONT");
+        _gfx->setTextSize(1);
+        _gfx->setCursor(75, 120); 
+        _gfx->setTextColor(LIGHTGREY);
+        _gfx->print("AR://WEAVEFRONT");
         
-        M5Cardputer.Display.setCursor(185, 120);
-        M5Cardputer.Display.setTextColor(YELLOW);
-        M5Cardputer.Display.print("v1.2(CYR)");
+        _gfx->setCursor(185, 120);
+        _gfx->setTextColor(YELLOW);
+        _gfx->print("v1.2(CYR)");
     }
 
-    M5Cardputer.Display.setFont(&Arial6pt16b);
+    _gfx->setFont(&Arial6pt16b);
 }
 
 void UI::drawMainMenu() {
-    M5Cardputer.Display.fillScreen(BLACK);
+    _gfx->fillScreen(BLACK);
+    markDirty(0, 0, SCREEN_W, SCREEN_H);
     // Start at search
 }
 
 void UI::drawSearch(bool fullRedraw) {
     if (fullRedraw) {
-         M5Cardputer.Display.fillScreen(BLACK);
-         M5Cardputer.Display.fillRect(0, 0, 240, 30, BLUE);
-         M5Cardputer.Display.setTextColor(WHITE);
-         M5Cardputer.Display.setTextSize(1);
-         M5Cardputer.Display.setCursor(10, 6);
-         M5Cardputer.Display.print("Search Wiki");
-         M5Cardputer.Display.drawRect(10, 50, 220, 40, WHITE);
-         M5Cardputer.Display.fillRect(0, 90, 240, 150, BLACK);
+         _gfx->fillScreen(BLACK);
+         markDirty(0, 0, SCREEN_W, SCREEN_H);
+         _gfx->fillRect(0, 0, 240, 30, BLUE);
+         _gfx->setTextColor(WHITE);
+         _gfx->setTextSize(1);
+         _gfx->setCursor(10, 6);
+         _gfx->print("Search Wiki");
+         _gfx->drawRect(10, 50, 220, 40, WHITE);
+         _gfx->fillRect(0, 90, 240, 150, BLACK);
     }
     
-    M5Cardputer.Display.fillRect(11, 51, 218, 38, BLACK);
-    M5Cardputer.Display.setCursor(20, 60);
-    M5Cardputer.Display.setTextSize(1); 
-    M5Cardputer.Display.setTextColor(GREEN); 
-    M5Cardputer.Display.print(_searchQuery);
-    if (millis() % 1000 < 500) M5Cardputer.Display.print("_"); 
+    _gfx->fillRect(11, 51, 218, 38, BLACK);
+    markDirty(11, 51, 218, 38);
+    _gfx->setCursor(20, 60);
+    _gfx->setTextSize(1); 
+    _gfx->setTextColor(GREEN); 
+    _gfx->print(_searchQuery);
+    if (millis() % 1000 < 500) _gfx->print("_"); 
     
     if (fullRedraw) {
         if (_uiMutex) xSemaphoreTake(_uiMutex, portMAX_DELAY);
         
         if (_searchQuery.length() > 0 && _searchResults.size() > 0) {
             int listY = 90;
-            M5Cardputer.Display.setTextSize(1);
-            M5Cardputer.Display.setCursor(10, listY - 10);
-            M5Cardputer.Display.setTextColor(YELLOW);
+            _gfx->setTextSize(1);
+            _gfx->setCursor(10, listY - 10);
+            _gfx->setTextColor(YELLOW);
             
             int maxItems = 6;
             for (int i=0; i < maxItems && i < _searchResults.size(); i++) {
-                 M5Cardputer.Display.setCursor(15, listY + (i * 15));
-                 M5Cardputer.Display.setTextColor(LIGHTGREY);
-                 M5Cardputer.Display.print(_searchResults[i]);
+                 _gfx->setCursor(15, listY + (i * 15));
+                 _gfx->setTextColor(LIGHTGREY);
+                 _gfx->print(_searchResults[i]);
             }
         } else {
-            M5Cardputer.Display.setTextSize(1);
-            M5Cardputer.Display.setCursor(10, 100);
-            M5Cardputer.Display.setTextColor(LIGHTGREY);
-            M5Cardputer.Display.print("Type query... Results appear here.");
+            _gfx->setTextSize(1);
+            _gfx->setCursor(10, 100);
+            _gfx->setTextColor(LIGHTGREY);
+            _gfx->print("Type query... Results appear here.");
         }
         
         if (_uiMutex) xSemaphoreGive(_uiMutex);
     }
 }
 
-void UI::drawResults() {
-    M5Cardputer.Display.fillScreen(BLACK);
-    
-    M5Cardputer.Display.fillRect(0, 0, 240, 25, ORANGE);
-    M5Cardputer.Display.setTextColor(BLACK);
-    M5Cardputer.Display.setTextSize(1);
-    M5Cardputer.Display.setCursor(5, 4);
-    M5Cardputer.Display.print("Results");
-    
+void UI::drawResults(bool fullRedraw) {
     int startY = 35;
     int lineHeight = 15; 
-    M5Cardputer.Display.setTextSize(1);
+    int maxItems = 6;
     
     if (_uiMutex) xSemaphoreTake(_uiMutex, portMAX_DELAY);
-
-    int maxItems = 6;
-    int startIdx = 0; 
     
+    int startIdx = 0; 
     if (_selectedResultIndex >= maxItems) {
         startIdx = _selectedResultIndex - maxItems + 1;
     }
     
+    // Highlight moved inside the same window: repaint the two rows only
+    bool rowsOnly = !fullRedraw && _resultsDrawn && startIdx == _drawnStartIdx;
+    
+    if (!rowsOnly) {
+        _gfx->fillScreen(BLACK);
+        markDirty(0, 0, SCREEN_W, SCREEN_H);
+        
+        _gfx->fillRect(0, 0, 240, 25, ORANGE);
+        _gfx->setTextColor(BLACK);
+        _gfx->setTextSize(1);
+        _gfx->setCursor(5, 4);
+        _gfx->print("Results");
+    }
+    
+    _gfx->setTextSize(1);
+    
     for (int i = 0; i < maxItems && (startIdx + i) < _searchResults.size(); i++) {
         int idx = startIdx + i;
         int y = startY + (i * lineHeight);
         
+        if (rowsOnly && idx != _selectedResultIndex && idx != _drawnSelectedIdx) continue;
+        
         if (idx == _selectedResultIndex) {
-            M5Cardputer.Display.fillRect(0, y-2, 240, lineHeight, WHITE);
-            M5Cardputer.Display.setTextColor(BLACK);
+            _gfx->fillRect(0, y-2, 240, lineHeight, WHITE);
+            _gfx->setTextColor(BLACK);
         } else {
-            M5Cardputer.Display.setTextColor(WHITE);
+            _gfx->fillRect(0, y-2, 240, lineHeight, BLACK);
+            _gfx->setTextColor(WHITE);
         }
+        markDirty(0, y-2, 240, lineHeight);
         
-        M5Cardputer.Display.setCursor(10, y);
-        M5Cardputer.Display.print(_searchResults[idx]);
+        _gfx->setCursor(10, y);
+        _gfx->print(_searchResults[idx]);
     }
     
+    _resultsDrawn = true;
+    _drawnStartIdx = startIdx;
+    _drawnSelectedIdx = _selectedResultIndex;
+    
     if (_uiMutex) xSemaphoreGive(_uiMutex);
 }
 
 void UI::drawReader() {
-    M5Cardputer.Display.fillScreen(BLACK);
-
-    M5Cardputer.Display.fillRect(0, 0, 240, 25, DARKGREY); 
-    M5Cardputer.Display.setCursor(5, 5);
-    M5Cardputer.Display.setTextSize(1); 
-    M5Cardputer.Display.setTextColor(WHITE);
-    M5Cardputer.Display.print(_articleTitle.substring(0, 18));
+    int pageLines = getReaderPageLines();
+    int lh = _layout.lineHeight();
+    int delta = _scrollPosition - _readerDrawnLine;
     
-    int contentY = 30; 
-    M5Cardputer.Display.setCursor(0, contentY); 
+    _gfx->setTextSize(1);
+    _gfx->setTextColor(WHITE);
     
-    M5Cardputer.Display.setTextSize(1);
-    M5Cardputer.Display.setTextColor(WHITE);
-    
-    if (_articleBuffer && _scrollPosition < strlen(_articleBuffer)) {
-        M5Cardputer.Display.print(_articleBuffer + _scrollPosition);
+    if (_gfx == &_canvas && _readerDrawnLine >= 0 && delta != 0 &&
+        delta < pageLines && delta > -pageLines) {
+        // Small scroll: blit the text already on the canvas by 'delta' lines
+        // and render only the rows that became exposed
+        _canvas.setScrollRect(0, READER_Y, READER_TEXT_W, pageLines * lh);
+        _canvas.scroll(0, -delta * lh);
+        _canvas.clearScrollRect();
+        
+        if (delta > 0) {
+            _layout.drawLines(*_gfx, _scrollPosition + pageLines - delta, delta,
+                              0, READER_Y + (pageLines - delta) * lh, WHITE);
+        } else {
+            _layout.drawLines(*_gfx, _scrollPosition, -delta, 0, READER_Y, WHITE);
+        }
+        markDirty(0, READER_Y, READER_TEXT_W, pageLines * lh);
+    } else if (delta != 0 || _readerDrawnLine < 0) {
+        _gfx->fillScreen(BLACK);
+        markDirty(0, 0, SCREEN_W, SCREEN_H);
+
+        _gfx->fillRect(0, 0, 240, 25, DARKGREY); 
+        _gfx->setCursor(5, 5);
+        _gfx->print(_articleTitle.substring(0, _showOpenHud ? 11 : 18));
+        
+        _layout.drawLines(*_gfx, _scrollPosition, pageLines, 0, READER_Y, WHITE);
     }
+    _readerDrawnLine = _scrollPosition;
     
-    if (_articleBuffer) {
-        int totalLen = strlen(_articleBuffer);
-        if (totalLen > 0) {
-            int viewH = 135 - contentY;
-            int barH = viewH * 300 / totalLen; 
-            
-            if (barH < 5) barH = 5;
-            if (barH > viewH) barH = viewH;
-            
-            int barY = contentY + ((viewH - barH) * _scrollPosition / totalLen);
-            
-            M5Cardputer.Display.fillRect(235, barY, 5, barH, LIGHTGREY);
-        }
+    int totalLines = _layout.lineCount();
+    if (totalLines > pageLines) {
+        int barH = READER_H * pageLines / totalLines;
+        
+        if (barH < 5) barH = 5;
+        if (barH > READER_H) barH = READER_H;
+        
+        int maxLine = totalLines - pageLines;
+        int barY = READER_Y + ((READER_H - barH) * _scrollPosition / maxLine);
+        
+        _gfx->fillRect(235, READER_Y, 5, READER_H, BLACK);
+        _gfx->fillRect(235, barY, 5, barH, LIGHTGREY);
+        markDirty(235, READER_Y, 5, READER_H);
     }
 }
 
 void UI::drawAbout() {
-    M5Cardputer.Display.fillScreen(BLACK);
-    M5Cardputer.Display.setCursor(10, 10);
-    M5Cardputer.Display.setTextSize(1);
-    M5Cardputer.Display.setTextColor(CYAN);
-    M5Cardputer.Display.println("WikiPuter");
-    M5Cardputer.Display.setTextSize(1);
-    M5Cardputer.Display.setTextColor(WHITE);
-    M5Cardputer.Display.println("\nOffline Wikipedia Reader\nFor M5Cardputer Adv.\n\nCreated with Gemini.");
-    M5Cardputer.Display.println("\nPress Enter/Del to Return");
+    _gfx->fillScreen(BLACK);
+    markDirty(0, 0, SCREEN_W, SCREEN_H);
+    _gfx->setCursor(10, 10);
+    _gfx->setTextSize(1);
+    _gfx->setTextColor(CYAN);
+    _gfx->println("WikiPuter");
+    _gfx->setTextSize(1);
+    _gfx->setTextColor(WHITE);
+    _gfx->println("\nOffline Wikipedia Reader\nFor M5Cardputer Adv.\n\nCreated with Gemini.");
+    _gfx->println("\nPress Enter/Del to Return");
+}
+
+void UI::drawDiagnostics() {
+    _gfx->fillScreen(BLACK);
+    markDirty(0, 0, SCREEN_W, SCREEN_H);
+    
+    _gfx->fillRect(0, 0, 240, 25, DARKGREY);
+    _gfx->setTextSize(1);
+    _gfx->setTextColor(WHITE);
+    _gfx->setCursor(5, 5);
+    _gfx->print("Diagnostics");
+    
+    int y = 30;
+    int start = 0;
+    while (start < (int)_diagnostics.length() && y < SCREEN_H - 12) {
+        int end = _diagnostics.indexOf('\n', start);
+        if (end < 0) end = _diagnostics.length();
+        _gfx->setCursor(5, y);
+        _gfx->print(_diagnostics.substring(start, end));
+        start = end + 1;
+        y += 13;
+    }
+    
+    _gfx->setTextColor(LIGHTGREY);
+    _gfx->setCursor(5, SCREEN_H - 13);
+    _gfx->print("Del: back");
 }
@@ -2,6 +2,7 @@
 #define UI_H
 
 #include <M5Cardputer.h>
+#include "TextLayout.h"
 
 enum AppState {
     STATE_SPLASH,
@@ -9,7 +10,8 @@ enum AppState {
     STATE_SEARCH,
     STATE_RESULTS,
     STATE_READING,
-    STATE_ABOUT
+    STATE_ABOUT,
+    STATE_DIAGNOSTICS
 };
 
 class UI {
@@ -23,6 +25,9 @@ public:
     
     // State management
     void setState(AppState newState);
+    // Back to a screen left for an overlay (diagnostics): full redraw, the
+    // reader's scroll position and the results selection are kept
+    void restoreState(AppState state);
     AppState getState();
 
     // Data passing
@@ -43,10 +48,30 @@ public:
     
     void setArticleTitle(String title);
     
+    // Timing of the last article open, drawn over the reader's title bar
+    // while enabled. Up to HUD_ROWS lines separated by '\n'. While the
+    // reader shows it, setting it redraws only the HUD.
+    void setOpenHud(const String& text);
+    void toggleOpenHud();
+    
+    // Body of the diagnostics screen, one row per '\n'
+    void setDiagnostics(const String& text);
+    
     // Input handling helpers
     void moveSelection(int delta);
-    void scrollReader(int delta);
+    void scrollReader(int delta); // In lines
+    int getReaderPageLines();
     void handleInput(Keyboard_Class::KeysState status);
+    
+    // Render timing, updated by every draw()
+    struct FrameStats {
+        unsigned long lastUs = 0;
+        unsigned long avgUs = 0;
+        unsigned long maxUs = 0;
+        unsigned long lastPixels = 0; // Pixels pushed to the panel
+        uint32_t frames = 0;
+    };
+    const FrameStats& getFrameStats();
 
 private:
     AppState _currentState;
@@ -63,9 +88,45 @@ private:
     
     SemaphoreHandle_t _uiMutex;
     
-    int _scrollPosition;
+    // Reader viewport (below the title bar, left of the scrollbar)
+    static const int READER_Y = 30;
+    static const int READER_H = 105;
+    static const int READER_TEXT_W = 232;
+    TextLayout _layout;
+    
+    int _scrollPosition; // First visible line
     String _statusMsg;
     
+    // Open timing overlay, right end of the reader title bar (built-in font)
+    static const int HUD_X = 144;
+    static const int HUD_ROWS = 3;
+    String _openHud;
+    bool _showOpenHud = false;
+    
+    String _diagnostics;
+    
+    // Off-screen canvas; all draw*() calls render through _gfx and
+    // flush() pushes only the dirty rectangles to the panel
+    static const int SCREEN_W = 240;
+    static const int SCREEN_H = 135;
+    static const int MAX_DIRTY = 8;
+    struct DirtyRect { int16_t x, y, w, h; };
+    
+    M5Canvas _canvas;
+    LovyanGFX* _gfx = nullptr;
+    DirtyRect _dirty[MAX_DIRTY];
+    int _dirtyCount = 0;
+    FrameStats _frameStats;
+    
+    // What drawResults() last put on screen
+    bool _resultsDrawn = false;
+    int _drawnStartIdx = 0;
+    int _drawnSelectedIdx = 0;
+    int _readerDrawnLine = -1; // First line on the canvas, -1 = needs full draw
+    
+    void markDirty(int x, int y, int w, int h);
+    void flush();
+    
     // Animation vars
     unsigned long _lastRefesh;
     int _animFrame;
@@ -74,9 +135,10 @@ private:
     void drawSplash();
     void drawMainMenu();
     void drawSearch(bool fullRedraw);
-    void drawResults();
+    void drawResults(bool fullRedraw);
     void drawReader();
     void drawAbout();
+    void drawDiagnostics();
     void drawStatusBar();
 };
 
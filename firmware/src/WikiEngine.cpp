@@ -1,6 +1,8 @@
 #include "WikiEngine.h"
 #include <M5Cardputer.h> // Debug
 #include <lgfx/utility/lgfx_miniz.h>
+#include "Trace.h"
+#include "MemStats.h"
 
 char32_t WikiEngine::decodeUTF8Char(const char*& ptr, const char* end) const {
     if (ptr >= end) return 0;
@@ -120,24 +122,35 @@ bool WikiEngine::begin() {
     }
     _totalEntries = fileSize / INDEX_RECORD_SIZE;
 
+    loadDictionary();
+    startUnzipTask(); // Retried by the first deflate open if the heap was short
     return true;
 }
 
+bool WikiEngine::getEntry(uint32_t index, WikiIndexEntry* outEntry) {
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+    bool res = readEntry(index, outEntry);
+    xSemaphoreGive(_mutex);
+    return res;
+}
+
 bool WikiEngine::readEntry(uint32_t index, WikiIndexEntry* outEntry) {
     if (index >= _totalEntries) return false;
     
     _idxFile.seek(index * INDEX_RECORD_SIZE);
+    _io.seeks++;
     
     // Read Title (52 bytes)
-    _idxFile.read((uint8_t*)outEntry->title, TITLE_LIMIT);
+    _io.bytes += _idxFile.read((uint8_t*)outEntry->title, TITLE_LIMIT);
     // Ensure null termination safely
     outEntry->title[TITLE_LIMIT - 1] = 0; 
 
     // Read Offset (8 bytes)
-    _idxFile.read((uint8_t*)&outEntry->offset, 8);
+    _io.bytes += _idxFile.read((uint8_t*)&outEntry->offset, 8);
     
     // Read Length (4 bytes)
-    _idxFile.read((uint8_t*)&outEntry->length, 4);
+    _io.bytes += _idxFile.read((uint8_t*)&outEntry->length, 4);
+    _io.reads += 3;
 
     return true;
 }
@@ -148,6 +161,7 @@ std::vector<String> WikiEngine::search(const String& query, int limit) {
     std::vector<String> results;
     // Mutex Lock
     xSemaphoreTake(_mutex, portMAX_DELAY);
+    TRACE_SCOPE("index search");
     
     if (_totalEntries == 0) {
         xSemaphoreGive(_mutex);
@@ -198,6 +212,7 @@ bool WikiEngine::loadRandom(char* buffer, uint32_t bufferSize, String& outTitle)
      }
 
      // Retry up to 20 times to find a "Main Namespace" article
+     unsigned long start = micros();
      for (int i=0; i<20; i++) {
         uint32_t randIdx = random(0, _totalEntries);
         
@@ -221,7 +236,10 @@ bool WikiEngine::loadRandom(char* buffer, uint32_t bufferSize, String& outTitle)
         // Found a good one!
         outTitle = t;
         // Assume loadArticleAt does NOT self-lock
+        uint32_t lookupUs = micros() - start;
         bool res = loadArticleAt(entry.offset, entry.length, buffer, bufferSize) > 0;
+        _lastOpen.lookupUs = lookupUs;
+        _lastOpen.totalUs += lookupUs;
         xSemaphoreGive(_mutex);
         return res;
      }
@@ -236,6 +254,8 @@ uint32_t WikiEngine::loadArticle(const String& title, char* buffer, uint32_t buf
     if (!buffer || bufferSize == 0) return 0;
     
     xSemaphoreTake(_mutex, portMAX_DELAY);
+    _lastOpen = OpenStats();
+    unsigned long start = micros();
     uint32_t low = 0;
     uint32_t high = _totalEntries - 1;
 
@@ -253,7 +273,10 @@ uint32_t WikiEngine::loadArticle(const String& title, char* buffer, uint32_t buf
                               title.c_str(), title.length());
         
         if (cmp == 0) {
+            uint32_t lookupUs = micros() - start;
             uint32_t res = loadArticleAt(entry.offset, entry.length, buffer, bufferSize);
+            _lastOpen.lookupUs = lookupUs;
+            _lastOpen.totalUs += lookupUs;
             xSemaphoreGive(_mutex);
             return res;
         } else if (cmp > 0) {
@@ -267,43 +290,253 @@ uint32_t WikiEngine::loadArticle(const String& title, char* buffer, uint32_t buf
     return strlen(buffer);
 }
 
-// Decompression Task Params
+static uint32_t adler32(const uint8_t* data, size_t len) {
+    uint32_t a = 1, b = 0;
+    while (len > 0) {
+        size_t n = len < 5552 ? len : 5552; // Largest run without overflow
+        len -= n;
+        while (n--) {
+            a += *data++;
+            b += a;
+        }
+        a %= 65521;
+        b %= 65521;
+    }
+    return (b << 16) | a;
+}
+
+void WikiEngine::loadDictionary() {
+    File f = SD.open("/wiki.dict", FILE_READ);
+    if (!f) return;
+
+    size_t len = f.size();
+    if (len == 0 || len > PRESET_DICT_SIZE) {
+        f.close();
+        return;
+    }
+
+    // Allocated once at boot, before the heap gets fragmented
+    _dict = (uint8_t*)calloc(1, PRESET_DICT_SIZE);
+    if (!_dict) {
+        f.close();
+        return;
+    }
+    memAlloc(MEM_DICT, PRESET_DICT_SIZE);
+
+    uint8_t* start = _dict + PRESET_DICT_SIZE - len;
+    if (f.read(start, len) != len) {
+        free(_dict);
+        memFree(MEM_DICT, PRESET_DICT_SIZE);
+        _dict = nullptr;
+    } else {
+        _dictId = adler32(start, len);
+    }
+    f.close();
+    if (!_dict) return;
+
+    // 8 hex digits, the Adler-32 of the dictionary the data was built with
+    File id = SD.open("/wiki.dictid", FILE_READ);
+    if (!id) return;
+    char hex[9] = {0};
+    id.read((uint8_t*)hex, 8);
+    id.close();
+    char* end;
+    uint32_t dataId = strtoul(hex, &end, 16);
+    _dictMatchesData = end == hex + 8 && dataId == _dictId;
+}
+
+// Job slot of the inflate task. The engine fills it and gives 'start';
+// the task sets 'done' when the result is in.
 struct DecompParams {
+    SemaphoreHandle_t start;
+    uint8_t* window; // tinfl window for dictionary records, null without wiki.dict
     uint8_t* src;
     size_t srcLen;
     char* dst;
     size_t dstLen;
+    const uint8_t* dict; // Preset window contents, or null
     size_t result;
+    uint32_t us; // Time spent decoding, without the wake-up
     volatile bool done;
 };
 
-// Worker Task
-void decompressTask(void* pv) {
-    DecompParams* params = (DecompParams*)pv;
-    
-    // Debug: Print stack size inside new task
-    // M5Cardputer.Display.printf("Task Stack: %u\n", uxTaskGetStackHighWaterMark(NULL));
-    // delay(500); // Visual confirm
+// Inflates through tinfl's 32KB circular window, seeded with the preset
+// dictionary so the first back-references of the stream can reach into it
+static size_t inflateWithDictionary(const uint8_t* src, size_t srcLen, uint8_t* dst, size_t dstLen,
+                                    const uint8_t* dict, uint8_t* window) {
+    memcpy(window, dict, PRESET_DICT_SIZE);
 
-    // Decompress RAW
-    params->result = lgfx_tinfl_decompress_mem_to_mem(
+    tinfl_decompressor decomp;
+    tinfl_init(&decomp);
+
+    size_t inPos = 0;
+    size_t outPos = 0;
+    size_t windowPos = 0;
+    tinfl_status status;
+    for (;;) {
+        size_t inBytes = srcLen - inPos;
+        size_t outBytes = PRESET_DICT_SIZE - windowPos;
+        status = lgfx_tinfl_decompress(&decomp, src + inPos, &inBytes,
+                                       window, window + windowPos, &outBytes, 0);
+        inPos += inBytes;
+
+        if (outPos + outBytes > dstLen) {
+            status = TINFL_STATUS_FAILED;
+            break;
+        }
+        memcpy(dst + outPos, window + windowPos, outBytes);
+        outPos += outBytes;
+        windowPos = (windowPos + outBytes) & (PRESET_DICT_SIZE - 1);
+
+        if (status != TINFL_STATUS_HAS_MORE_OUTPUT) break;
+    }
+
+    return (status == TINFL_STATUS_DONE) ? outPos : (size_t)-1;
+}
+
+// Decodes one LZ4 block. Returns the decoded size, or (size_t)-1 if the
+// block is malformed or does not fit. Literals are moved with memmove so the
+// source may sit behind the output in the same buffer.
+static size_t lz4Decompress(const uint8_t* src, size_t srcLen, uint8_t* dst, size_t dstLen) {
+    TRACE_SCOPE("lz4");
+    const uint8_t* ip = src;
+    const uint8_t* iend = src + srcLen;
+    uint8_t* op = dst;
+    uint8_t* oend = dst + dstLen;
+
+    while (ip < iend) {
+        uint8_t token = *ip++;
+
+        size_t lit = token >> 4;
+        if (lit == 15) {
+            uint8_t b;
+            do {
+                if (ip >= iend) return (size_t)-1;
+                b = *ip++;
+                lit += b;
+            } while (b == 255);
+        }
+        if (lit > (size_t)(iend - ip) || lit > (size_t)(oend - op)) return (size_t)-1;
+        memmove(op, ip, lit);
+        op += lit;
+        ip += lit;
+
+        if (ip >= iend) break; // The last sequence is literals only
+
+        if (iend - ip < 2) return (size_t)-1;
+        size_t dist = ip[0] | (ip[1] << 8);
+        ip += 2;
+        if (dist == 0 || dist > (size_t)(op - dst)) return (size_t)-1;
+
+        size_t match = token & 15;
+        if (match == 15) {
+            uint8_t b;
+            do {
+                if (ip >= iend) return (size_t)-1;
+                b = *ip++;
+                match += b;
+            } while (b == 255);
+        }
+        match += 4;
+        if (match > (size_t)(oend - op)) return (size_t)-1;
+
+        // Byte by byte: the match may overlap what it is producing
+        const uint8_t* m = op - dist;
+        while (match--) *op++ = *m++;
+    }
+    return op - dst;
+}
+
+static size_t runDecoder(const DecompParams* params) {
+    TRACE_SCOPE("inflate");
+    if (params->dict) {
+        return inflateWithDictionary(params->src, params->srcLen,
+                                     (uint8_t*)params->dst, params->dstLen, params->dict, params->window);
+    }
+    return lgfx_tinfl_decompress_mem_to_mem(
         (uint8_t*)params->dst, 
         params->dstLen, 
         params->src, 
         params->srcLen, 
         0
     );
-    
-    params->done = true;
-    vTaskDelete(NULL);
+}
+
+// Stack of the inflate task, in bytes on the ESP32
+#define UNZIP_STACK_SIZE 32768
+
+// Worker Task: sleeps until the engine hands it a record
+void decompressTask(void* pv) {
+    DecompParams* params = (DecompParams*)pv;
+    for (;;) {
+        xSemaphoreTake(params->start, portMAX_DELAY);
+        unsigned long start = micros();
+        params->result = runDecoder(params);
+        params->us = micros() - start;
+        params->done = true;
+    }
+}
+
+bool WikiEngine::startUnzipTask() {
+    if (_unzipJob) return true;
+
+    DecompParams* job = (DecompParams*)calloc(1, sizeof(DecompParams));
+    if (!job) return false;
+    job->done = true;
+    job->start = xSemaphoreCreateBinary();
+    if (_dict) job->window = (uint8_t*)malloc(PRESET_DICT_SIZE);
+    if (!job->start || (_dict && !job->window) ||
+        xTaskCreate(decompressTask, "unzip", UNZIP_STACK_SIZE, job, 1, NULL) != pdPASS) {
+        if (job->start) vSemaphoreDelete(job->start);
+        free(job->window);
+        free(job);
+        return false;
+    }
+    memAlloc(MEM_UNZIP_TASK, UNZIP_STACK_SIZE);
+    if (job->window) memAlloc(MEM_DICT, PRESET_DICT_SIZE);
+    _unzipJob = job;
+    return true;
 }
 
 uint32_t WikiEngine::loadArticleAt(uint64_t offset, uint32_t length, char* buffer, uint32_t bufferSize) {
+    TRACE_SCOPE("load article");
+    _lastOpen = OpenStats();
+    _lastOpen.heapBefore = ESP.getFreeHeap();
+    unsigned long start = micros();
+    
+    uint32_t res = readArticleAt(offset, length, buffer, bufferSize);
+    
+    _lastOpen.totalUs = micros() - start;
+    _lastOpen.heapAfter = ESP.getFreeHeap();
+    return res;
+}
+
+uint32_t WikiEngine::readArticleAt(uint64_t offset, uint32_t length, char* buffer, uint32_t bufferSize) {
     if (!buffer || bufferSize == 0) return 0;
 
     // Decode Packed Offset
-    uint32_t fileIndex = (uint32_t)(offset >> 32);
+    uint32_t fileIndex = (uint32_t)(offset >> OFFSET_FILE_SHIFT) & 0xFF;
     uint32_t localOffset = (uint32_t)(offset & 0xFFFFFFFF);
+    uint8_t codec = (uint8_t)(offset >> OFFSET_CODEC_SHIFT) & 0x0F;
+    uint32_t rawLength = (uint32_t)(offset >> OFFSET_SIZE_SHIFT);
+    _lastOpen.codec = codec;
+    _lastOpen.bytesIn = length;
+    if (codec > CODEC_RAW_DEFLATE_DICT) {
+        snprintf(buffer, bufferSize, "Error: Unknown codec %u.", codec);
+        return strlen(buffer);
+    }
+    if (rawLength >= bufferSize) {
+        // Known up front: no point reading it
+        snprintf(buffer, bufferSize, "Error: Article too large (%u bytes).", rawLength);
+        return strlen(buffer);
+    }
+    if (codec == CODEC_RAW_DEFLATE_DICT && !_dictMatchesData) {
+        snprintf(buffer, bufferSize, _dict ? "Error: wiki.dict does not match this data (wiki.dictid)."
+                                           : "Error: wiki.dict missing.");
+        return strlen(buffer);
+    }
+    // Exact output size when the index has it, else whatever fits
+    size_t outLimit = rawLength ? rawLength : bufferSize - 1;
     
     // POLISHED LOADING SCREEN
     M5Cardputer.Display.fillScreen(BLACK);
@@ -320,16 +553,22 @@ uint32_t WikiEngine::loadArticleAt(uint64_t offset, uint32_t length, char* buffe
     sprintf(fileName, "/wiki.dat.%03u", fileIndex);
     
     // Close previous
+    unsigned long t = micros();
     if (_datFile) _datFile.close();
     
     _datFile = SD.open(fileName, FILE_READ);
+    _lastOpen.openUs = micros() - t;
     if (!_datFile) {
         snprintf(buffer, bufferSize, "Error: Open %s failed.", fileName);
         return strlen(buffer);
     }
     M5Cardputer.Display.fillRect(42, 82, 40, 6, WHITE); // Update
     
-    if (!_datFile.seek(localOffset)) {
+    _io.seeks++;
+    t = micros();
+    bool seeked = _datFile.seek(localOffset);
+    _lastOpen.seekUs = micros() - t;
+    if (!seeked) {
         snprintf(buffer, bufferSize, "Error: Seek failed.");
         return strlen(buffer);
     }
@@ -338,25 +577,81 @@ uint32_t WikiEngine::loadArticleAt(uint64_t offset, uint32_t length, char* buffe
     // Cap input size was here, removed.
     // if (length > 30000) length = 30000; 
     
-    uint8_t* compressed = (uint8_t*)malloc(length);
+    // In place: stage the blob at the (word aligned) end of the output buffer
+    // and decode forward over it. Needs the stored length, the margin check
+    // covers the alignment slack. Older records get their own input buffer.
+    bool inPlace = rawLength > 0 && codec != CODEC_DEFLATE &&
+                   (uint64_t)rawLength + IN_PLACE_MARGIN + 4 <= bufferSize - 1;
+    _lastOpen.inPlace = inPlace;
+    uint8_t* compressed;
+    if (inPlace) {
+        uintptr_t stage = ((uintptr_t)buffer + bufferSize - 1 - length) & ~(uintptr_t)3;
+        compressed = (uint8_t*)stage;
+    } else {
+        compressed = (uint8_t*)malloc(length);
+    }
     if (!compressed) {
-        snprintf(buffer, bufferSize, "Error: OOM waiting for input buffer (%u)", length);
+        snprintf(buffer, bufferSize, "Error: OOM waiting for input buffer (%u, largest free %u)",
+                 length, (unsigned)ESP.getMaxAllocHeap());
         return strlen(buffer);
     }
+    if (!inPlace) memAlloc(MEM_ARTICLE_INPUT, length);
+    auto releaseInput = [&]() {
+        if (inPlace) return;
+        free(compressed);
+        memFree(MEM_ARTICLE_INPUT, length);
+    };
+    _lastOpen.heapLow = ESP.getFreeHeap();
     
+    t = micros();
     size_t bytesRead = _datFile.read(compressed, length);
+    _lastOpen.readUs = micros() - t;
+    _io.reads++;
+    _io.bytes += bytesRead;
     if (bytesRead != length) {
-        free(compressed);
-        snprintf(buffer, bufferSize, "Error: Read %u / %u bytes.", bytesRead, length);
+        releaseInput();
+        snprintf(buffer, bufferSize, "Error: Read %u / %u bytes.", (unsigned)bytesRead, length);
         return strlen(buffer);
     }
     M5Cardputer.Display.fillRect(42, 82, 120, 6, WHITE); // Update
     
-    // Check for ZLIB header
+    if (codec == CODEC_LZ4) {
+        // Fast enough to run inline, and needs no extra stack
+        t = micros();
+        size_t outLen = lz4Decompress(compressed, length, (uint8_t*)buffer, outLimit);
+        _lastOpen.inflateUs = micros() - t;
+        releaseInput();
+        if (outLen == (size_t)-1 || (rawLength && outLen != rawLength)) {
+            snprintf(buffer, bufferSize, "Error: LZ4 decode failed (L:%u)", length);
+            return strlen(buffer);
+        }
+        buffer[outLen] = 0;
+        _lastOpen.bytesOut = outLen;
+        _lastOpen.ok = true;
+        return outLen;
+    }
+    
+    // Raw deflate starts right at the (aligned) malloc'd buffer. Only older
+    // zlib records need their header sniffed and stripped.
     size_t headerOffset = 0;
-    if (length > 6 && compressed[0] == 0x78 && 
+    bool usesDict = (codec == CODEC_RAW_DEFLATE_DICT);
+    if (codec != CODEC_DEFLATE) {
+        // Nothing to strip
+    } else if (length > 6 && compressed[0] == 0x78 && 
        (compressed[1] == 0x01 || compressed[1] == 0x9C || compressed[1] == 0xDA)) {
          headerOffset = 2;
+    } else if (length > 10 && compressed[0] == 0x78 && (compressed[1] & 0x20) &&
+               ((compressed[0] << 8) | compressed[1]) % 31 == 0) {
+        // FDICT: a 4-byte DICTID follows, naming the preset dictionary
+        uint32_t dictId = ((uint32_t)compressed[2] << 24) | ((uint32_t)compressed[3] << 16) |
+                          ((uint32_t)compressed[4] << 8) | compressed[5];
+        if (!_dict || dictId != _dictId) {
+            releaseInput();
+            snprintf(buffer, bufferSize, "Error: wiki.dict missing or does not match this data.");
+            return strlen(buffer);
+        }
+        headerOffset = 6;
+        usesDict = true;
     }
 
     // ALIGNMENT FIX: memmove to ensure 32-bit alignment
@@ -369,17 +664,29 @@ uint32_t WikiEngine::loadArticleAt(uint64_t offset, uint32_t length, char* buffe
         sourceLen -= 4; // Strip Adler32
     }
     
-    // START NEW TASK 
-    DecompParams params;
+    // Hand the record to the inflate task
+    if (!startUnzipTask()) {
+        releaseInput();
+        snprintf(buffer, bufferSize, "Error: OOM starting unzip task (largest free %u)",
+                 (unsigned)ESP.getMaxAllocHeap());
+        return strlen(buffer);
+    }
+    DecompParams& params = *_unzipJob;
+    if (!params.done) {
+        // Still on a record that timed out
+        releaseInput();
+        snprintf(buffer, bufferSize, "Error: Unzip task busy");
+        return strlen(buffer);
+    }
     params.src = compressed;
     params.srcLen = sourceLen;
     params.dst = buffer;
-    params.dstLen = bufferSize - 1;
-    params.done = false;
+    params.dstLen = outLimit;
+    params.dict = usesDict ? _dict : nullptr;
     params.result = (size_t)-1;
-
-    // Create Task (32KB stack task)
-    xTaskCreate(decompressTask, "unzip", 32768, &params, 1, NULL);
+    params.us = 0;
+    params.done = false;
+    xSemaphoreGive(params.start);
 
     int timeout = 1000;
     while (!params.done && timeout > 0) {
@@ -390,21 +697,25 @@ uint32_t WikiEngine::loadArticleAt(uint64_t offset, uint32_t length, char* buffe
     }
     
     if (timeout == 0) {
-        free(compressed);
+        // The task may still read the input: leave it allocated (it stays
+        // visible as live "article in" bytes in the memory dump)
         snprintf(buffer, bufferSize, "Error: Task Timeout");
         return strlen(buffer);
     }
     
     size_t status = params.result;
+    _lastOpen.inflateUs = params.us;
     
-    if (status != (size_t)-1) {
+    if (status != (size_t)-1 && (!rawLength || status == rawLength)) {
         buffer[status] = 0; 
-        free(compressed);
+        releaseInput();
+        _lastOpen.bytesOut = status;
+        _lastOpen.ok = true;
         return status;
     } 
 
-    free(compressed);
-    snprintf(buffer, bufferSize, "Error: Depack Fail %d (L:%d)", status, sourceLen);
+    releaseInput();
+    snprintf(buffer, bufferSize, "Error: Depack Fail %d (L:%u)", (int)status, (unsigned)sourceLen);
     // Only show error delay on failure
     delay(2000); 
     return strlen(buffer);
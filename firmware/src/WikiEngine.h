@@ -8,6 +8,25 @@
 // Keep in sync with converter.py
 #define INDEX_RECORD_SIZE 64
 #define TITLE_LIMIT 52
+// Preset deflate dictionary written by converter.py --dict (one deflate window)
+#define PRESET_DICT_SIZE 32768
+
+// Packed offset: bits 0-31 offset in the shard, 32-39 shard number,
+// 40-43 codec of the record, 44-63 uncompressed length (0 = unknown)
+#define OFFSET_FILE_SHIFT 32
+#define OFFSET_CODEC_SHIFT 40
+#define OFFSET_SIZE_SHIFT 44
+
+// converter.py guarantees that no record with a stored length needs more
+// than this many bytes past its decoded end when it is decoded in place
+#define IN_PLACE_MARGIN 4096
+
+enum WikiCodec : uint8_t {
+    CODEC_DEFLATE = 0,         // zlib stream, optionally with the preset dictionary
+    CODEC_LZ4 = 1,             // LZ4 block, no frame
+    CODEC_RAW_DEFLATE = 2,     // Raw deflate, no zlib header or Adler-32
+    CODEC_RAW_DEFLATE_DICT = 3 // Raw deflate against the preset dictionary
+};
 
 struct WikiIndexEntry {
     char title[TITLE_LIMIT];
@@ -32,10 +51,60 @@ public:
     // Internal loader (exposed for debug/advanced usage)
     uint32_t loadArticleAt(uint64_t offset, uint32_t length, char* buffer, uint32_t bufferSize);
 
+    // SD accesses made by search and load, for benchmarks
+    struct IoStats {
+        uint32_t seeks = 0;
+        uint32_t reads = 0;
+        uint64_t bytes = 0;
+    };
+    const IoStats& getIoStats() const { return _io; }
+    void resetIoStats() { _io = IoStats(); }
+    uint32_t getEntryCount() const { return _totalEntries; }
+    // Index record by position, for tools walking the whole data set
+    bool getEntry(uint32_t index, WikiIndexEntry* outEntry);
+
+    // Stage breakdown of the last loadArticle/loadRandom, in microseconds
+    struct OpenStats {
+        uint32_t lookupUs = 0;  // Index search (loadArticle) or pick (loadRandom)
+        uint32_t openUs = 0;    // SD.open of the shard
+        uint32_t seekUs = 0;
+        uint32_t readUs = 0;
+        uint32_t inflateUs = 0; // Decoder only, measured inside the unzip task
+        uint32_t totalUs = 0;
+        uint32_t bytesIn = 0;   // Compressed bytes read
+        uint32_t bytesOut = 0;  // Decoded bytes, 0 on failure
+        uint32_t heapBefore = 0;
+        uint32_t heapLow = 0;   // Free heap with the input buffer allocated
+        uint32_t heapAfter = 0;
+        uint8_t codec = 0;
+        bool inPlace = false;
+        bool ok = false;
+    };
+    const OpenStats& getLastOpen() const { return _lastOpen; }
+
 private:
     File _idxFile;
     File _datFile;
     uint32_t _totalEntries = 0;
+    IoStats _io;
+    OpenStats _lastOpen;
+
+    // Preset dictionary, right-aligned in a PRESET_DICT_SIZE buffer so it can
+    // be copied straight into tinfl's window. Null if the card has none.
+    uint8_t* _dict = nullptr;
+    uint32_t _dictId = 0; // Adler-32, matches the zlib DICTID field
+    // wiki.dictid (written with the index) names _dict: raw deflate records
+    // carry no DICTID of their own, so codec 3 is refused without a match
+    bool _dictMatchesData = false;
+    void loadDictionary();
+
+    // Inflate task and its job slot, started once at boot with its stack and
+    // the dictionary window so an open allocates nothing (see WikiEngine.cpp)
+    struct DecompParams* _unzipJob = nullptr;
+    bool startUnzipTask();
+
+    // loadArticleAt without the bookkeeping of _lastOpen's totals
+    uint32_t readArticleAt(uint64_t offset, uint32_t length, char* buffer, uint32_t bufferSize);
 
     // Helper to read an entry at a specific index
     bool readEntry(uint32_t index, WikiIndexEntry* outEntry);
@@ -0,0 +1,253 @@
+#include "WikiText.h"
+#include <string.h>
+#include "Trace.h"
+
+// strstr/strchr that remember their last answer. The cleaner's read
+// pointer only moves forward and it never writes ahead of it, so a hit
+// still ahead of 'from' (or no hit at all) stays the answer. Without this
+// every unclosed <ref or stray '<' rescans the rest of the article.
+struct Finder {
+    const char* needle;
+    char* hit = nullptr;
+    bool searched = false;
+
+    explicit Finder(const char* n) : needle(n) {}
+
+    char* next(char* from) {
+        if (!searched || (hit && hit < from)) {
+            hit = needle[1] ? strstr(from, needle) : strchr(from, needle[0]);
+            searched = true;
+        }
+        return hit;
+    }
+};
+
+void cleanWikiText(char* buf) {
+    if (!buf) return;
+    TRACE_SCOPE("clean");
+    
+    char* src = buf;
+    char* dst = buf;
+    
+    // We strictly skip blocks. 
+    // nesting is critical.
+    Finder refCloser("</ref>");
+    Finder tagEnd(">");
+    const char* skipTags[] = {"table", "gallery", "script", "style", "div"}; // Maybe div is too aggressive? Infoboxes often use divs.
+    Finder skipClosers[] = {Finder("</table>"), Finder("</gallery>"), Finder("</script>"),
+                            Finder("</style>"), Finder("</div>")};
+    char* linkDeadEnd = nullptr; // A [[ before this has no ]] on its line
+    
+// ... (Start of function)
+    while (*src) {
+        // 1. HTML Comments <!-- ... -->
+        if (src[0] == '<' && src[1] == '!' && src[2] == '-' && src[3] == '-') {
+             src += 4;
+             while (*src) {
+                 if (src[0] == '-' && src[1] == '-' && src[2] == '>') {
+                     src += 3;
+                     break;
+                 }
+                 src++;
+             }
+             continue;
+        }
+
+        // 2. Refs <ref ...> ... </ref> (Strip CONTENT)
+        if (strncmp(src, "<ref", 4) == 0) {
+             src += 4;
+             // Self-closing <ref name="x" /> ends with its own tag,
+             // otherwise the content runs to </ref>
+             char* tagClose = tagEnd.next(src);
+             if (!tagClose) {
+                 // Broken ref, drop the rest
+                 src += strlen(src);
+                 continue;
+             }
+             if (tagClose[-1] == '/') {
+                 src = tagClose + 1;
+                 continue;
+             }
+             char* closer = refCloser.next(tagClose);
+             // Unclosed: strip just the tag
+             src = closer ? closer + 6 : tagClose + 1;
+             continue;
+        }
+
+// ...
+        // 3. Generic Tags & Specific Block Tags
+        if (*src == '<') {
+             // A. Scripts/Styles/Galleries/Tables (Strip Content)
+             // Check for <table, <gallery, <script, <style
+             bool strictSkip = false;
+             
+             // Check if it's a closing tag </... (Ignore, handled by loop)
+             if (src[1] == '/') {
+                 // Just a loose closing tag? Strip it.
+                 char* end = tagEnd.next(src);
+                 if (end) { src = end+1; continue; }
+             }
+             
+             for (int t = 0; t < (int)(sizeof(skipTags) / sizeof(skipTags[0])); t++) {
+                 const char* tag = skipTags[t];
+                 size_t len = strlen(tag);
+                 // Check <TAG or <TAG> or <TAG (space)
+                 if (strncmp(src+1, tag, len) == 0 && (src[1+len] == '>' || src[1+len] == ' ')) {
+                     strictSkip = true;
+                     // Find closing tag </TAG>
+                     // Simple scan? Nested tables?
+                     // Wiki HTML is usually well formed.
+                     // Let's simple scan for </TAG> for now to avoid stack complexity.
+                     // We must handle case-insensitivity roughly? Wiki is lowercase standard.
+                     char* closePtr = skipClosers[t].next(src);
+                     if (closePtr) {
+                         src = closePtr + strlen(skipClosers[t].needle);
+                     } else {
+                         // Unclosed? Strip tag only
+                         char* end = tagEnd.next(src);
+                         if (end) src = end + 1;
+                         else src++;
+                     }
+                     break; 
+                 }
+             }
+             if (strictSkip) continue;
+             
+             // B. Generic Tags (Strip Tag, Keep Content)
+             // e.g. <small>, <b>, <span>
+             char* end = tagEnd.next(src);
+             if (end && (end - src < 64)) { 
+                 src = end + 1;
+                 continue;
+             }
+        }
+// ...
+
+        // 4. Recursive Blocks: {{...}} and {|...|}
+        if ((src[0] == '{' && src[1] == '{') || (src[0] == '{' && src[1] == '|')) {
+            char open1 = src[0];
+            char open2 = src[1]; // '{' or '|'
+            // Determine close signature
+            // {{ -> }}
+            // {| -> |}
+            char close1 = (open2 == '|') ? '|' : '}';
+            char close2 = '}';
+            
+            int depth = 1;
+            src += 2;
+            while (*src && depth > 0) {
+                // Check Open
+                if (src[0] == open1 && src[1] == open2) { depth++; src+=2; }
+                // Check Close
+                else if (src[0] == close1 && src[1] == close2) { depth--; src+=2; }
+                else src++;
+            }
+            continue;
+        }
+
+        // 5. Links & Files: [[ ... ]]
+        if (src[0] == '[' && src[1] == '[') {
+            // Check for Meta-Prefixes to Skip Block
+            bool isMeta = false;
+            if (strncmp(src+2, "File:", 5) == 0) isMeta = true;
+            else if (strncmp(src+2, "Image:", 6) == 0) isMeta = true;
+            else if (strncmp(src+2, "Category:", 9) == 0) isMeta = true;
+            
+            if (isMeta) {
+                // Recursive Skip
+                int depth = 1;
+                src += 2;
+                while (*src && depth > 0) {
+                    if (src[0] == '[' && src[1] == '[') { depth++; src+=2; }
+                    else if (src[0] == ']' && src[1] == ']') { depth--; src+=2; }
+                    else src++;
+                }
+                continue;
+            }
+            
+            // Standard Link: [[Target|Label]] -> Keep Label
+            // Standard Link: [[Target]] -> Keep Target
+            // Heuristic: Scan for '|' or ']]'
+            // We do NOT handle nested links here (rare in standard links).
+            if (src < linkDeadEnd) {
+                // The scan from an earlier [[ already failed on this line
+                src += 2;
+                continue;
+            }
+            char* ptr = src + 2;
+            char* pipe = nullptr;
+            char* end = nullptr;
+            
+            while (*ptr) {
+                if (*ptr == ']' && *(ptr+1) == ']') { end = ptr; break; }
+                if (*ptr == '|' && !pipe) pipe = ptr;
+                if (*ptr == '\n' || *ptr == '{') break; // Safety break
+                ptr++;
+            }
+            
+            if (end) {
+                char* textStart = pipe ? pipe + 1 : src + 2;
+                int len = end - textStart;
+                if (len > 0) {
+                    // Copy text to dst
+                    memmove(dst, textStart, len); // memmove in case of overlap? src>dst always.
+                    // Actually we are writing to dst which is same buffer. Manual copy safest.
+                    for (int k=0; k<len; k++) *dst++ = textStart[k];
+                }
+                src = end + 2;
+            } else {
+                // Broken or complex link, just strip brackets?
+                linkDeadEnd = ptr;
+                src += 2; 
+            }
+            continue;
+        }
+        
+        // 6. Formatting: ''' or '' -> Skip
+        if (src[0] == '\'' && src[1] == '\'') {
+            src += 2;
+            if (*src == '\'') src++;
+            continue;
+        }
+
+        // 7. Magic Words: __NOTOC__
+        if (src[0] == '_' && src[1] == '_') {
+            if (strncmp(src, "__NOTOC__", 9) == 0) { src += 9; continue; }
+            if (strncmp(src, "__TOC__", 7) == 0) { src += 7; continue; }
+            if (strncmp(src, "__NOEDITSECTION__", 17) == 0) { src += 17; continue; }
+        }
+
+        *dst++ = *src++;
+    }
+    *dst = 0;
+    
+    // Pass 2: Whitespace Compaction (Existing Logic)
+    // Pass 2: Whitespace Compaction (Existing Logic)
+    src = buf;
+    dst = buf;
+    int newlineCount = 0;
+    bool leading = true; 
+    
+    while (*src) {
+        char c = *src;
+        if (c == '\r') { src++; continue; }
+        
+        if (c == '\n') {
+            if (leading) { src++; continue; }
+            newlineCount++;
+            if (newlineCount <= 2) *dst++ = '\n';
+        } else if (c == ' ' || c == '\t') {
+           if (leading || newlineCount > 0) {
+               // strip
+           } else {
+               *dst++ = ' '; // Normalize spaces
+           }
+        } else {
+            leading = false;
+            newlineCount = 0; 
+            *dst++ = c;
+        }
+        src++;
+    }
+    *dst = 0;
+}
@@ -0,0 +1,9 @@
+#ifndef WIKI_TEXT_H
+#define WIKI_TEXT_H
+
+// Strips wiki markup (comments, templates, refs, tags, link syntax,
+// tables) from a NUL-terminated article, in place. Free of Arduino and
+// display dependencies so it also builds for the native environment.
+void cleanWikiText(char* buf);
+
+#endif
@@ -1,6 +1,11 @@
 #include <M5Cardputer.h>
 #include "WikiEngine.h"
 #include "UI.h"
+#include "Bench.h"
+#include "WikiText.h"
+#include "Trace.h"
+#include "MemStats.h"
+#include "Latency.h"
 
 WikiEngine engine;
 UI ui;
@@ -8,11 +13,26 @@ UI ui;
 // Async Search Globals
 QueueHandle_t searchQ;
 volatile bool resultsReady = false;
+volatile unsigned long resultsKeyUs = 0; // Key event behind the ready results
+volatile uint32_t resultsVisit = 0;      // searchVisit when that key was typed
 
 struct SearchReq {
     char query[64];
+    unsigned long keyUs; // micros() of the key event that issued it
+    uint32_t visit;      // searchVisit at that key
 };
 
+// End to end, key event to display push done: a key in the search screen
+// until its results are shown (keys whose query was overwritten before the
+// worker took it get no sample), Enter on a result until the article's
+// first page is shown
+LatencyWindow searchLatency;
+LatencyWindow openLatency;
+AppState diagnosticsReturn = STATE_SEARCH;
+// Counts entries into the search screen. Results of a key typed on an
+// earlier visit spent part of their wait on another screen: shown, not timed.
+uint32_t searchVisit = 0;
+
 void searchWorkerTask(void* pv) {
     SearchReq req;
     while (true) {
@@ -21,245 +41,14 @@ void searchWorkerTask(void* pv) {
              std::vector<String> res = engine.search(q, 100);
              
              ui.setResults(res); 
+             resultsKeyUs = req.keyUs;
+             resultsVisit = req.visit;
              resultsReady = true;
         }
         vTaskDelay(10); // CRITICAL: Prevent Starvation / Watchdog
     }
 }
 
-void cleanWikiText(char* buf) {
-    if (!buf) return;
-    
-    char* src = buf;
-    char* dst = buf;
-    
-    // We strictly skip blocks. 
-    // nesting is critical.
-    
-// ... (Start of function)
-    while (*src) {
-        // 1. HTML Comments <!-- ... -->
-        if (src[0] == '<' && src[1] == '!' && src[2] == '-' && src[3] == '-') {
-             src += 4;
-             while (*src) {
-                 if (src[0] == '-' && src[1] == '-' && src[2] == '>') {
-                     src += 3;
-                     break;
-                 }
-                 src++;
-             }
-             continue;
-        }
-
-        // 2. Templates {{ ... }} - Recursive
-        if (src[0] == '{' && src[1] == '{') {
-            int depth = 1;
-             char* end = strstr(src, "-->");
-             if (end) src = end + 3;
-             else break; // Safety
-             continue;
-        }
-
-        // 2. Refs <ref ...> ... </ref> (Strip CONTENT)
-        if (strncmp(src, "<ref", 4) == 0) {
-             src += 4;
-             // Handle simple self-close <ref name="x" />
-             // We need to find closer. heuristic: look for /> or </ref>
-             // But content inside might contain anything.
-             // Simplest robust way: Scan for </ref>. If not found, maybe it was self closing.
-             char* closer = strstr(src, "</ref>");
-             char* selfCloser = strstr(src, "/>");
-             
-             // Pick earliest
-             if (closer && (!selfCloser || closer < selfCloser)) {
-                 src = closer + 6;
-             } else if (selfCloser) {
-                 src = selfCloser + 2;
-             } else {
-                 // Broken ref, just skip tag
-                 while (*src && *src != '>') src++;
-                 if (*src) src++;
-             }
-             continue;
-        }
-
-// ...
-        // 3. Generic Tags & Specific Block Tags
-        if (*src == '<') {
-             // A. Scripts/Styles/Galleries/Tables (Strip Content)
-             // Check for <table, <gallery, <script, <style
-             const char* skipTags[] = {"table", "gallery", "script", "style", "div"}; // Maybe div is too aggressive? Infoboxes often use divs.
-             // Let's stick to table/gallery/script/style for now.
-             bool strictSkip = false;
-             
-             // Check if it's a closing tag </... (Ignore, handled by loop)
-             if (src[1] == '/') {
-                 // Just a loose closing tag? Strip it.
-                 char* end = strchr(src, '>');
-                 if (end) { src = end+1; continue; }
-             }
-             
-             for (const char* tag : skipTags) {
-                 size_t len = strlen(tag);
-                 // Check <TAG or <TAG> or <TAG (space)
-                 if (strncmp(src+1, tag, len) == 0 && (src[1+len] == '>' || src[1+len] == ' ')) {
-                     strictSkip = true;
-                     // Find closing tag </TAG>
-                     // Simple scan? Nested tables?
-                     // Wiki HTML is usually well formed.
-                     // Let's simple scan for </TAG> for now to avoid stack complexity.
-                     // Construct closer </TAG>
-                     char closer[16];
-                     snprintf(closer, 16, "</%s>", tag);
-                     
-                     // Find it
-                     // We must handle case-insensitivity roughly? Wiki is lowercase standard.
-                     char* closePtr = strstr(src, closer);
-                     if (closePtr) {
-                         src = closePtr + strlen(closer);
-                     } else {
-                         // Unclosed? Strip tag only
-                         char* end = strchr(src, '>');
-                         if (end) src = end + 1;
-                     }
-                     break; 
-                 }
-             }
-             if (strictSkip) continue;
-             
-             // B. Generic Tags (Strip Tag, Keep Content)
-             // e.g. <small>, <b>, <span>
-             char* end = strchr(src, '>');
-             if (end && (end - src < 64)) { 
-                 src = end + 1;
-                 continue;
-             }
-        }
-// ...
-
-        // 4. Recursive Blocks: {{...}} and {|...|}
-        if ((src[0] == '{' && src[1] == '{') || (src[0] == '{' && src[1] == '|')) {
-            char open1 = src[0];
-            char open2 = src[1]; // '{' or '|'
-            // Determine close signature
-            // {{ -> }}
-            // {| -> |}
-            char close1 = (open2 == '|') ? '|' : '}';
-            char close2 = '}';
-            
-            int depth = 1;
-            src += 2;
-            while (*src && depth > 0) {
-                // Check Open
-                if (src[0] == open1 && src[1] == open2) { depth++; src+=2; }
-                // Check Close
-                else if (src[0] == close1 && src[1] == close2) { depth--; src+=2; }
-                else src++;
-            }
-            continue;
-        }
-
-        // 5. Links & Files: [[ ... ]]
-        if (src[0] == '[' && src[1] == '[') {
-            // Check for Meta-Prefixes to Skip Block
-            bool isMeta = false;
-            if (strncmp(src+2, "File:", 5) == 0) isMeta = true;
-            else if (strncmp(src+2, "Image:", 6) == 0) isMeta = true;
-            else if (strncmp(src+2, "Category:", 9) == 0) isMeta = true;
-            
-            if (isMeta) {
-                // Recursive Skip
-                int depth = 1;
-                src += 2;
-                while (*src && depth > 0) {
-                    if (src[0] == '[' && src[1] == '[') { depth++; src+=2; }
-                    else if (src[0] == ']' && src[1] == ']') { depth--; src+=2; }
-                    else src++;
-                }
-                continue;
-            }
-            
-            // Standard Link: [[Target|Label]] -> Keep Label
-            // Standard Link: [[Target]] -> Keep Target
-            // Heuristic: Scan for '|' or ']]'
-            // We do NOT handle nested links here (rare in standard links).
-            char* ptr = src + 2;
-            char* pipe = nullptr;
-            char* end = nullptr;
-            
-            while (*ptr) {
-                if (*ptr == ']' && *(ptr+1) == ']') { end = ptr; break; }
-                if (*ptr == '|' && !pipe) pipe = ptr;
-                if (*ptr == '\n' || *ptr == '{') break; // Safety break
-                ptr++;
-            }
-            
-            if (end) {
-                char* textStart = pipe ? pipe + 1 : src + 2;
-                int len = end - textStart;
-                if (len > 0) {
-                    // Copy text to dst
-                    memmove(dst, textStart, len); // memmove in case of overlap? src>dst always.
-                    // Actually we are writing to dst which is same buffer. Manual copy safest.
-                    for (int k=0; k<len; k++) *dst++ = textStart[k];
-                }
-                src = end + 2;
-            } else {
-                // Broken or complex link, just strip brackets?
-                src += 2; 
-            }
-            continue;
-        }
-        
-        // 6. Formatting: ''' or '' -> Skip
-        if (src[0] == '\'' && src[1] == '\'') {
-            src += 2;
-            if (*src == '\'') src++;
-            continue;
-        }
-
-        // 7. Magic Words: __NOTOC__
-        if (src[0] == '_' && src[1] == '_') {
-            if (strncmp(src, "__NOTOC__", 9) == 0) { src += 9; continue; }
-            if (strncmp(src, "__TOC__", 7) == 0) { src += 7; continue; }
-            if (strncmp(src, "__NOEDITSECTION__", 17) == 0) { src += 17; continue; }
-        }
-
-        *dst++ = *src++;
-    }
-    *dst = 0;
-    
-    // Pass 2: Whitespace Compaction (Existing Logic)
-    // Pass 2: Whitespace Compaction (Existing Logic)
-    src = buf;
-    dst = buf;
-    int newlineCount = 0;
-    bool leading = true; 
-    
-    while (*src) {
-        char c = *src;
-        if (c == '\r') { src++; continue; }
-        
-        if (c == '\n') {
-            if (leading) { src++; continue; }
-            newlineCount++;
-            if (newlineCount <= 2) *dst++ = '\n';
-        } else if (c == ' ' || c == '\t') {
-           if (leading || newlineCount > 0) {
-               // strip
-           } else {
-               *dst++ = ' '; // Normalize spaces
-           }
-        } else {
-            leading = false;
-            newlineCount = 0; 
-            *dst++ = c;
-        }
-        src++;
-    }
-    *dst = 0;
-}
-
 bool isRussianLayout = true;
 
 String russianCharToUTF8(char latinKey) {
@@ -340,6 +129,10 @@ void setup() {
     M5Cardputer.begin(cfg, true);
     M5Cardputer.Display.setRotation(1);
     
+#ifdef WIKI_BENCH
+    benchRender();
+#endif
+
     ui.begin();
     
     // SD Pins (Standard for Original & ADV): SCK=40, MISO=39, MOSI=14, CS=12
@@ -368,6 +161,11 @@ void setup() {
         while(1) delay(100);
     }
 
+#ifdef WIKI_BENCH
+    benchSearch(engine);
+    benchScreens(engine, ui);
+#endif
+
     // INIT ASYNC SEARCH (Increased Stack to 16KB for stability)
     searchQ = xQueueCreate(1, sizeof(SearchReq)); 
     xTaskCreate(searchWorkerTask, "search", 16384, NULL, 1, NULL); 
@@ -375,6 +173,113 @@ void setup() {
     ui.setState(STATE_SEARCH); 
 }
 
+// Heap history interval (see MemStats.h); opening an article also samples
+#define MEM_SAMPLE_MS 10000
+
+void sampleHeap() {
+    if (memSample()) {
+        Serial.printf("warning: largest free block %u B, free heap %u B\n",
+                      (unsigned)ESP.getMaxAllocHeap(), (unsigned)ESP.getFreeHeap());
+    }
+}
+
+void printLatency(const char* name, const LatencyWindow& w) {
+    Serial.printf("latency %-11s n=%u p50=%uus p95=%uus last=%uus\n", name, (unsigned)w.total(),
+                  (unsigned)w.percentile(50), (unsigned)w.percentile(95), (unsigned)w.last());
+}
+
+// Single-letter commands from the serial monitor
+void handleSerialCommand(char c) {
+    switch (c) {
+        case 'm':
+            memDump([](const char* line) { Serial.println(line); });
+            break;
+        case 'w': {
+            // "w64": warn when the largest free block drops below 64 KB
+            long kb = Serial.parseInt();
+            if (kb > 0) {
+                memSetWarnThreshold(kb * 1024);
+                Serial.printf("heap warning below a %ld KB block\n", kb);
+            }
+            break;
+        }
+        case 'l':
+            printLatency("key>results", searchLatency);
+            printLatency("enter>text", openLatency);
+            break;
+#ifdef WIKI_TRACE
+        case 't':
+            traceDump(Serial);
+            break;
+#endif
+    }
+}
+
+// Rows of the diagnostics screen: both latencies, the last frame, the heap
+void showDiagnostics() {
+    const UI::FrameStats& f = ui.getFrameStats();
+    char text[256];
+    snprintf(text, sizeof(text),
+             "Key > results (%u)\n  p50 %.1f ms   p95 %.1f ms\n"
+             "Enter > text (%u)\n  p50 %.1f ms   p95 %.1f ms\n"
+             "Frame %.1f ms, avg %.1f, max %.1f\n"
+             "Heap %u KB, largest block %u KB",
+             (unsigned)searchLatency.total(), searchLatency.percentile(50) / 1000.0f,
+             searchLatency.percentile(95) / 1000.0f,
+             (unsigned)openLatency.total(), openLatency.percentile(50) / 1000.0f,
+             openLatency.percentile(95) / 1000.0f,
+             f.lastUs / 1000.0f, f.avgUs / 1000.0f, f.maxUs / 1000.0f,
+             (unsigned)(ESP.getFreeHeap() / 1024), (unsigned)(ESP.getMaxAllocHeap() / 1024));
+    ui.setDiagnostics(text);
+    ui.setState(STATE_DIAGNOSTICS);
+}
+
+// Cleans and lays out the article the engine just loaded into the UI
+// buffer, shows it, and reports where the time of the open went.
+// Returns the time from 'keyUs' until the first page was on the panel.
+unsigned long showArticle(const String& title, unsigned long keyUs) {
+    unsigned long t = micros();
+    cleanWikiText(ui.getArticleBuffer());
+    unsigned long cleanUs = micros() - t;
+    
+    t = micros();
+    ui.setArticleTitle(title);
+    ui.setArticleText(ui.getArticleBuffer());
+    unsigned long layoutUs = micros() - t;
+    
+    // Three 16-column rows in milliseconds and KB: SD vs decoder,
+    // cleaner vs layout + paint, heap before > lowest > after.
+    // Set before the paint so its first frame shows this open.
+    const WikiEngine::OpenStats& o = engine.getLastOpen();
+    unsigned long sdUs = o.openUs + o.seekUs + o.readUs;
+    char hud[64];
+    auto formatHud = [&](unsigned long uiUs) {
+        snprintf(hud, sizeof(hud), "sd%6.1f z%6.1f\ncl%6.1f ui%5.1f\nhp%4u>%4u>%4u",
+                 sdUs / 1000.0f, o.inflateUs / 1000.0f, cleanUs / 1000.0f, uiUs / 1000.0f,
+                 o.heapBefore / 1024, o.heapLow / 1024, o.heapAfter / 1024);
+        ui.setOpenHud(hud);
+    };
+    formatHud(layoutUs);
+    
+    t = micros();
+    ui.setState(STATE_READING);
+    M5Cardputer.Display.waitDisplay();
+    unsigned long paintUs = micros() - t;
+    unsigned long firstPaintUs = micros() - keyUs;
+    
+    Serial.printf("open \"%s\": %s codec %u%s, %u -> %u B | lookup %u open %u seek %u read %u inflate %u "
+                  "clean %lu layout %lu paint %lu total %lu us, first paint %lu us | heap %u / %u / %u\n",
+                  title.c_str(), o.ok ? "ok" : "FAIL", o.codec, o.inPlace ? " in place" : "",
+                  o.bytesIn, o.bytesOut, o.lookupUs, o.openUs, o.seekUs, o.readUs, o.inflateUs,
+                  cleanUs, layoutUs, paintUs, o.totalUs + cleanUs + layoutUs + paintUs, firstPaintUs,
+                  o.heapBefore, o.heapLow, o.heapAfter);
+    
+    // Add the paint to the ui field; only the HUD rectangle is redrawn
+    formatHud(layoutUs + paintUs);
+    sampleHeap();
+    return firstPaintUs;
+}
+
 void removeLastUTF8Char(String &q) {
     if (q.length() == 0) return;
     
@@ -401,6 +306,20 @@ void removeLastUTF8Char(String &q) {
 void loop() {
     M5Cardputer.update();
     
+    while (Serial.available()) handleSerialCommand(Serial.read());
+    
+    static unsigned long lastMemSample = 0;
+    if (millis() - lastMemSample > MEM_SAMPLE_MS) {
+        sampleHeap();
+        lastMemSample = millis();
+    }
+    
+    static AppState lastState = STATE_SEARCH;
+    if (ui.getState() != lastState) {
+        lastState = ui.getState();
+        if (lastState == STATE_SEARCH) searchVisit++;
+    }
+
     // Global Draw Update (cursors blinking etc)
     if (ui.getState() == STATE_SEARCH) {
         static unsigned long lastBlinkTime = 0;
@@ -413,10 +332,31 @@ void loop() {
         if (resultsReady) {
             resultsReady = false;
             ui.draw(); // Redraw with new results (This draws list)
+            M5Cardputer.Display.waitDisplay();
+            if (resultsVisit == searchVisit) searchLatency.add(micros() - resultsKeyUs);
+        }
+    }
+
+    // Holding '.' / ';' in the reader scrolls line by line after the first page jump
+    if (ui.getState() == STATE_READING) {
+        static unsigned long holdStart = 0;
+        static unsigned long lastStep = 0;
+        int dir = 0;
+        if (M5Cardputer.Keyboard.isKeyPressed('.')) dir = 1;
+        else if (M5Cardputer.Keyboard.isKeyPressed(';')) dir = -1;
+        
+        if (dir == 0) {
+            holdStart = 0;
+        } else if (holdStart == 0) {
+            holdStart = millis();
+        } else if (millis() - holdStart > 400 && millis() - lastStep > 40) {
+            ui.scrollReader(dir);
+            lastStep = millis();
         }
     }
 
     if (M5Cardputer.Keyboard.isChange() && M5Cardputer.Keyboard.isPressed()) {
+        unsigned long keyUs = micros();
         Keyboard_Class::KeysState status = M5Cardputer.Keyboard.keysState();
         AppState state = ui.getState();
 
@@ -430,6 +370,17 @@ void loop() {
              return; 
         }
 
+        // Opt: diagnostics screen, Del or Enter goes back
+        if (state == STATE_DIAGNOSTICS) {
+            if (status.del || status.enter) ui.restoreState(diagnosticsReturn);
+            return;
+        }
+        if (status.opt) {
+            diagnosticsReturn = state;
+            showDiagnostics();
+            return;
+        }
+
         if (state == STATE_SEARCH) {
             bool updateQuery = false;
             String q = ui.getSearchQuery();
@@ -461,6 +412,8 @@ void loop() {
                     SearchReq req;
                     strncpy(req.query, searchQStr.c_str(), 63);
                     req.query[63] = 0;
+                    req.keyUs = keyUs;
+                    req.visit = searchVisit;
                     xQueueOverwrite(searchQ, &req); // Non-blocking overwrite
                 } else {
                      // Empty query -> Clear results immediately
@@ -479,12 +432,7 @@ void loop() {
                      // EMPTY QUERY + ENTER = RANDOM ARTICLE
                      String title;
                      if (engine.loadRandom(ui.getArticleBuffer(), ui.getArticleBufferSize(), title)) {
-                        // Use Helper
-                        cleanWikiText(ui.getArticleBuffer());
-
-                        ui.setArticleTitle(title);
-                        ui.setArticleText(ui.getArticleBuffer());
-                        ui.setState(STATE_READING);
+                        showArticle(title, keyUs);
                      }
                 }
             }
@@ -495,13 +443,7 @@ void loop() {
                 String title = ui.getResult(ui.getSelectedResultIndex());
                 if (title.length() > 0) {
                     engine.loadArticle(title, ui.getArticleBuffer(), ui.getArticleBufferSize());
-                    
-                    // Use Helper
-                    cleanWikiText(ui.getArticleBuffer());
-                    
-                    ui.setArticleTitle(title);
-                    ui.setArticleText(ui.getArticleBuffer());
-                    ui.setState(STATE_READING);
+                    openLatency.add(showArticle(title, keyUs));
                 }
             }
             else if (status.del) { ui.setState(STATE_SEARCH); }
@@ -511,8 +453,9 @@ void loop() {
         }
         else if (state == STATE_READING) {
             if (status.del && M5Cardputer.Keyboard.isKeyPressed(KEY_BACKSPACE)) { ui.setState(STATE_RESULTS); }
-            if (M5Cardputer.Keyboard.isKeyPressed('.') || status.tab) { ui.scrollReader(150); }
-            if (M5Cardputer.Keyboard.isKeyPressed(';')) { ui.scrollReader(-150); }
+            if (M5Cardputer.Keyboard.isKeyPressed('.') || status.tab) { ui.scrollReader(ui.getReaderPageLines() - 1); }
+            if (M5Cardputer.Keyboard.isKeyPressed(';')) { ui.scrollReader(-(ui.getReaderPageLines() - 1)); }
+            if (M5Cardputer.Keyboard.isKeyPressed('i')) { ui.toggleOpenHud(); }
         }
     }
     
@@ -0,0 +1,61 @@
+#ifndef NATIVE_ARDUINO_H
+#define NATIVE_ARDUINO_H
+
+// Host stand-in for the parts of the Arduino core the engine uses
+// (native environment only, see platformio.ini)
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include "NativeRtos.h"
+
+class String {
+public:
+    String() {}
+    String(const char* s) : _s(s ? s : "") {}
+    String(const std::string& s) : _s(s) {}
+    explicit String(char c) : _s(1, c) {}
+
+    const char* c_str() const { return _s.c_str(); }
+    unsigned int length() const { return _s.length(); }
+    bool startsWith(const String& prefix) const { return _s.compare(0, prefix._s.size(), prefix._s) == 0; }
+    char operator[](unsigned int i) const { return i < _s.size() ? _s[i] : 0; }
+    int indexOf(char c, unsigned int from = 0) const {
+        size_t pos = _s.find(c, from);
+        return pos == std::string::npos ? -1 : (int)pos;
+    }
+    String substring(unsigned int from, unsigned int to) const {
+        if (to > _s.size()) to = _s.size();
+        return from < to ? String(_s.substr(from, to - from)) : String();
+    }
+
+    String& operator+=(const String& rhs) { _s += rhs._s; return *this; }
+    String operator+(const String& rhs) const { return String(_s + rhs._s); }
+    bool operator==(const String& rhs) const { return _s == rhs._s; }
+    bool operator!=(const String& rhs) const { return _s != rhs._s; }
+
+private:
+    std::string _s;
+};
+
+#define PROGMEM
+
+unsigned long millis();
+unsigned long micros();
+void delay(uint32_t ms);
+long random(long min, long max);
+
+// The host has no fixed heap to report: the counters read as zero
+class EspClass {
+public:
+    uint32_t getFreeHeap() { return 0; }
+    uint32_t getMaxAllocHeap() { return 0; }
+    uint32_t getMinFreeHeap() { return 0; }
+    uint32_t getPsramSize() { return 0; }
+    uint32_t getFreePsram() { return 0; }
+};
+extern EspClass ESP;
+
+#endif
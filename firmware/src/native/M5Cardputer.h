@@ -0,0 +1,42 @@
+#ifndef NATIVE_M5CARDPUTER_H
+#define NATIVE_M5CARDPUTER_H
+
+// Headless M5Cardputer for the native environment: the display is a
+// 240x135 framebuffer (NativeGfx.h) nothing ever shows, and there is no
+// keyboard to read.
+
+#include "Arduino.h"
+#include "SD.h"
+#include "NativeGfx.h"
+#include <vector>
+
+enum : uint16_t {
+    BLACK = 0x0000,
+    WHITE = 0xFFFF,
+    RED = 0xF800,
+    GREEN = 0x07E0,
+    BLUE = 0x001F,
+    CYAN = 0x07FF,
+    YELLOW = 0xFFE0,
+    DARKGREY = 0x7BEF,
+    LIGHTGREY = 0xD69A,
+    ORANGE = 0xFDA0,
+};
+
+// Only the type, for UI::handleInput's signature
+struct Keyboard_Class {
+    struct KeysState {
+        std::vector<char> word;
+        bool del = false;
+        bool enter = false;
+        bool tab = false;
+    };
+};
+
+struct NativeCardputer {
+    LovyanGFX Display{240, 135};
+};
+
+extern NativeCardputer M5Cardputer;
+
+#endif
@@ -0,0 +1,60 @@
+#include "M5Cardputer.h"
+#include <chrono>
+#include <random>
+#include <thread>
+
+NativeCardputer M5Cardputer;
+SDClass SD;
+EspClass ESP;
+
+static const auto bootTime = std::chrono::steady_clock::now();
+
+unsigned long millis() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - bootTime).count();
+}
+
+unsigned long micros() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - bootTime).count();
+}
+
+void delay(uint32_t ms) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+long random(long min, long max) {
+    static std::mt19937 rng(12345); // Fixed seed: runs are repeatable
+    if (max <= min) return min;
+    return min + (long)(rng() % (unsigned long)(max - min));
+}
+
+size_t File::size() {
+    if (!_f) return 0;
+    off_t here = ftello(_f.get());
+    fseeko(_f.get(), 0, SEEK_END);
+    off_t end = ftello(_f.get());
+    fseeko(_f.get(), here, SEEK_SET);
+    return (size_t)end;
+}
+
+bool SDClass::begin(const char* root) {
+    _root = root ? root : ".";
+    return true;
+}
+
+std::string SDClass::resolve(const char* path) const {
+    while (*path == '/') path++;
+    return _root + "/" + path;
+}
+
+File SDClass::open(const char* path, const char* mode) {
+    return File(fopen(resolve(path).c_str(), mode));
+}
+
+bool SDClass::exists(const char* path) {
+    FILE* f = fopen(resolve(path).c_str(), "rb");
+    if (!f) return false;
+    fclose(f);
+    return true;
+}
@@ -0,0 +1,157 @@
+#include "NativeGfx.h"
+#include <stdarg.h>
+
+void LovyanGFX::resize(int w, int h) {
+    _w = w;
+    _h = h;
+    _pixels.assign((size_t)w * h, 0);
+    clearClipRect();
+}
+
+uint16_t LovyanGFX::readPixel(int x, int y) const {
+    if (x < 0 || y < 0 || x >= _w || y >= _h) return 0;
+    return _pixels[(size_t)y * _w + x];
+}
+
+void LovyanGFX::setClipRect(int x, int y, int w, int h) {
+    _clipX0 = x < 0 ? 0 : x;
+    _clipY0 = y < 0 ? 0 : y;
+    _clipX1 = x + w > _w ? _w : x + w;
+    _clipY1 = y + h > _h ? _h : y + h;
+}
+
+void LovyanGFX::fillRect(int x, int y, int w, int h, uint16_t color) {
+    int x0 = x < _clipX0 ? _clipX0 : x;
+    int y0 = y < _clipY0 ? _clipY0 : y;
+    int x1 = x + w > _clipX1 ? _clipX1 : x + w;
+    int y1 = y + h > _clipY1 ? _clipY1 : y + h;
+    for (int row = y0; row < y1; row++) {
+        uint16_t* p = &_pixels[(size_t)row * _w];
+        for (int col = x0; col < x1; col++) p[col] = color;
+    }
+}
+
+void LovyanGFX::drawRect(int x, int y, int w, int h, uint16_t color) {
+    fillRect(x, y, w, 1, color);
+    fillRect(x, y + h - 1, w, 1, color);
+    fillRect(x, y, 1, h, color);
+    fillRect(x + w - 1, y, 1, h, color);
+}
+
+size_t LovyanGFX::write(const uint8_t* s, size_t len) {
+    for (size_t i = 0; i < len; i++) write(s[i]);
+    return len;
+}
+
+size_t LovyanGFX::write(uint8_t c) {
+    if (_utf8More > 0 && (c & 0xC0) == 0x80) {
+        _utf8 = (_utf8 << 6) | (c & 0x3F);
+        if (--_utf8More == 0) drawChar(_utf8);
+        return 1;
+    }
+    _utf8More = 0;
+    if ((c & 0xE0) == 0xC0) { _utf8 = c & 0x1F; _utf8More = 1; }
+    else if ((c & 0xF0) == 0xE0) { _utf8 = c & 0x0F; _utf8More = 2; }
+    else if ((c & 0xF8) == 0xF0) { _utf8 = c & 0x07; _utf8More = 3; }
+    else drawChar(c);
+    return 1;
+}
+
+size_t LovyanGFX::printf(const char* format, ...) {
+    char buf[256];
+    va_list args;
+    va_start(args, format);
+    int n = vsnprintf(buf, sizeof(buf), format, args);
+    va_end(args);
+    return n > 0 ? print(buf) : 0;
+}
+
+void LovyanGFX::drawChar(uint32_t cp) {
+    int s = _textSize;
+    int lineHeight = _font ? _font->yAdvance : 8;
+    if (cp == '\n') {
+        _cursorX = 0;
+        _cursorY += lineHeight * s;
+        return;
+    }
+    if (cp == '\r') return;
+
+    if (!_font) {
+        if (cp != ' ') fillRect(_cursorX, _cursorY, 5 * s, 7 * s, _textColor);
+        _cursorX += 6 * s;
+        return;
+    }
+
+    if (cp < _font->first || cp > _font->last) return;
+    const GFXglyph& g = _font->glyph[cp - _font->first];
+    const uint8_t* bits = _font->bitmap + g.bitmapOffset;
+    int baseline = _cursorY + (lineHeight - 1) * s;
+
+    uint8_t byte = 0;
+    uint8_t mask = 0;
+    for (int row = 0; row < g.height; row++) {
+        for (int col = 0; col < g.width; col++) {
+            if (!mask) { byte = *bits++; mask = 0x80; }
+            if (byte & mask) {
+                fillRect(_cursorX + (g.xOffset + col) * s, baseline + (g.yOffset + row) * s, s, s, _textColor);
+            }
+            mask >>= 1;
+        }
+    }
+    _cursorX += g.xAdvance * s;
+}
+
+void* LGFX_Sprite::createSprite(int w, int h) {
+    resize(w, h);
+    clearScrollRect();
+    return _pixels.data();
+}
+
+void LGFX_Sprite::pushSprite(int x, int y) {
+    LovyanGFX* dst = _parent;
+    if (!dst) return;
+    int x0 = x < dst->_clipX0 ? dst->_clipX0 : x;
+    int y0 = y < dst->_clipY0 ? dst->_clipY0 : y;
+    int x1 = x + _w > dst->_clipX1 ? dst->_clipX1 : x + _w;
+    int y1 = y + _h > dst->_clipY1 ? dst->_clipY1 : y + _h;
+    if (x1 <= x0) return;
+    for (int row = y0; row < y1; row++) {
+        memcpy(&dst->_pixels[(size_t)row * dst->_w + x0],
+               &_pixels[(size_t)(row - y) * _w + (x0 - x)], (x1 - x0) * sizeof(uint16_t));
+    }
+}
+
+void LGFX_Sprite::setScrollRect(int x, int y, int w, int h) {
+    _scrollX = x;
+    _scrollY = y;
+    _scrollW = w;
+    _scrollH = h;
+}
+
+void LGFX_Sprite::scroll(int dx, int dy) {
+    int x0 = _scrollX < 0 ? 0 : _scrollX;
+    int y0 = _scrollY < 0 ? 0 : _scrollY;
+    int x1 = _scrollX + _scrollW > _w ? _w : _scrollX + _scrollW;
+    int y1 = _scrollY + _scrollH > _h ? _h : _scrollY + _scrollH;
+    int w = x1 - x0;
+    if (w <= 0 || y1 <= y0) return;
+
+    // Row order such that every source row is read before it is overwritten
+    std::vector<uint16_t> row(w);
+    int count = y1 - y0;
+    for (int i = 0; i < count; i++) {
+        int dstY = dy > 0 ? y1 - 1 - i : y0 + i;
+        int srcY = dstY - dy;
+        uint16_t* dst = &_pixels[(size_t)dstY * _w + x0];
+        if (srcY < y0 || srcY >= y1) {
+            for (int col = 0; col < w; col++) dst[col] = 0;
+            continue;
+        }
+        const uint16_t* src = &_pixels[(size_t)srcY * _w + x0];
+        for (int col = 0; col < w; col++) {
+            int sx = col - dx;
+            row[col] = sx >= 0 && sx < w ? src[sx] : 0;
+        }
+        memcpy(dst, row.data(), w * sizeof(uint16_t));
+    }
+}
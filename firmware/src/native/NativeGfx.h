@@ -0,0 +1,98 @@
+#ifndef NATIVE_GFX_H
+#define NATIVE_GFX_H
+
+// The LovyanGFX calls the UI makes, drawn in software into an RGB565
+// framebuffer (native environment only). The panel is a framebuffer too,
+// so on the host a frame costs the same drawing and the same pixel copies
+// as on the device, minus the SPI transfer. The built-in 6x8 font is not
+// carried over: its text is drawn as solid 5x7 cells.
+
+#include <Arduino.h>
+#include <lgfx/v1/lgfx_fonts.hpp>
+#include <vector>
+
+class LovyanGFX {
+public:
+    LovyanGFX() {}
+    LovyanGFX(int w, int h) { resize(w, h); }
+    virtual ~LovyanGFX() {}
+
+    int width() const { return _w; }
+    int height() const { return _h; }
+    uint16_t readPixel(int x, int y) const;
+
+    void startWrite() {}
+    void endWrite() {}
+    void setClipRect(int x, int y, int w, int h);
+    void clearClipRect() { setClipRect(0, 0, _w, _h); }
+
+    void fillScreen(uint16_t color) { fillRect(0, 0, _w, _h, color); }
+    void fillRect(int x, int y, int w, int h, uint16_t color);
+    void drawRect(int x, int y, int w, int h, uint16_t color);
+    void writeFastHLine(int x, int y, int w, uint16_t color) { fillRect(x, y, w, 1, color); }
+    void drawPixel(int x, int y, uint16_t color) { fillRect(x, y, 1, 1, color); }
+
+    // Text: UTF-8, GFX fonts or (NULL) the built-in font, no wrapping
+    void setFont(const GFXfont* font) { _font = font; }
+    void setTextSize(int size) { _textSize = size > 0 ? size : 1; }
+    void setTextColor(uint16_t color) { _textColor = color; }
+    void setTextColor(uint16_t color, uint16_t) { _textColor = color; }
+    void setTextWrap(bool) {}
+    void setCursor(int x, int y) { _cursorX = x; _cursorY = y; }
+
+    size_t write(uint8_t c);
+    size_t write(const uint8_t* s, size_t len);
+    size_t print(const char* s) { return write((const uint8_t*)s, strlen(s)); }
+    size_t print(const String& s) { return print(s.c_str()); }
+    size_t println(const char* s = "") { size_t n = print(s); return n + write('\n'); }
+    size_t println(const String& s) { return println(s.c_str()); }
+    size_t printf(const char* format, ...);
+
+protected:
+    std::vector<uint16_t> _pixels;
+    int _w = 0, _h = 0;
+    int _clipX0 = 0, _clipY0 = 0, _clipX1 = 0, _clipY1 = 0; // Exclusive end
+
+    void resize(int w, int h);
+
+private:
+    const GFXfont* _font = nullptr;
+    int _textSize = 1;
+    uint16_t _textColor = 0xFFFF;
+    int _cursorX = 0, _cursorY = 0;
+    uint32_t _utf8 = 0; // Codepoint being decoded
+    int _utf8More = 0;  // Continuation bytes still expected
+
+    void drawChar(uint32_t cp);
+
+    friend class LGFX_Sprite;
+};
+
+class LGFX_Sprite : public LovyanGFX {
+public:
+    explicit LGFX_Sprite(LovyanGFX* parent = nullptr) : _parent(parent) {}
+
+    // Pixels are stored as RGB565 whatever the depth; the depth only
+    // decides what bufferLength() reports, as on the device
+    void setColorDepth(int bits) { _depth = bits; }
+    void* createSprite(int w, int h);
+    void deleteSprite() { resize(0, 0); }
+    size_t bufferLength() const { return (size_t)_w * _h * _depth / 8; }
+
+    // Copies into the parent through the parent's clip rect
+    void pushSprite(int x, int y);
+
+    // scroll() moves the pixels inside the scroll rect, clearing what it exposes
+    void setScrollRect(int x, int y, int w, int h);
+    void clearScrollRect() { setScrollRect(0, 0, _w, _h); }
+    void scroll(int dx, int dy);
+
+private:
+    LovyanGFX* _parent;
+    int _depth = 16;
+    int _scrollX = 0, _scrollY = 0, _scrollW = 0, _scrollH = 0;
+};
+
+typedef LGFX_Sprite M5Canvas;
+
+#endif
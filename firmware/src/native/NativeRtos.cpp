@@ -0,0 +1,73 @@
+#include "NativeRtos.h"
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+// A mutex locks 'm'. A binary semaphore is 'given' under 'lock' instead,
+// since a std mutex may not be unlocked by another thread than its owner.
+struct NativeMutex {
+    std::timed_mutex m;
+    bool binary = false;
+    bool given = false;
+    std::mutex lock;
+    std::condition_variable cv;
+};
+
+SemaphoreHandle_t xSemaphoreCreateMutex() {
+    return new NativeMutex();
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary() {
+    NativeMutex* sem = new NativeMutex();
+    sem->binary = true;
+    return sem;
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t sem) {
+    delete sem;
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t mutex, TickType_t ticks) {
+    if (mutex->binary) {
+        std::unique_lock<std::mutex> hold(mutex->lock);
+        auto given = [mutex] { return mutex->given; };
+        if (ticks == portMAX_DELAY) {
+            mutex->cv.wait(hold, given);
+        } else if (!mutex->cv.wait_for(hold, std::chrono::milliseconds(ticks), given)) {
+            return pdFALSE;
+        }
+        mutex->given = false;
+        return pdTRUE;
+    }
+    if (ticks == portMAX_DELAY) {
+        mutex->m.lock();
+        return pdTRUE;
+    }
+    return mutex->m.try_lock_for(std::chrono::milliseconds(ticks)) ? pdTRUE : pdFALSE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t mutex) {
+    if (mutex->binary) {
+        std::lock_guard<std::mutex> hold(mutex->lock);
+        mutex->given = true;
+        mutex->cv.notify_one();
+        return pdTRUE;
+    }
+    mutex->m.unlock();
+    return pdTRUE;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t fn, const char* name, uint32_t stackDepth,
+                       void* arg, int priority, TaskHandle_t* handle) {
+    std::thread(fn, arg).detach();
+    if (handle) *handle = nullptr;
+    return pdPASS;
+}
+
+void vTaskDelete(TaskHandle_t task) {
+}
+
+void vTaskDelay(TickType_t ticks) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ticks));
+}
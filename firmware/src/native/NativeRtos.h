@@ -0,0 +1,34 @@
+#ifndef NATIVE_RTOS_H
+#define NATIVE_RTOS_H
+
+// FreeRTOS primitives the engine uses, mapped onto std threads.
+// One tick is one millisecond, as on the Cardputer.
+
+#include <stdint.h>
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef void (*TaskFunction_t)(void*);
+typedef struct NativeTask* TaskHandle_t;
+typedef struct NativeMutex* SemaphoreHandle_t;
+
+#define portMAX_DELAY 0xFFFFFFFFu
+#define pdTRUE 1
+#define pdFALSE 0
+#define pdPASS 1
+
+SemaphoreHandle_t xSemaphoreCreateMutex();
+// Given by one thread, taken by another; starts empty
+SemaphoreHandle_t xSemaphoreCreateBinary();
+void vSemaphoreDelete(SemaphoreHandle_t sem);
+BaseType_t xSemaphoreTake(SemaphoreHandle_t mutex, TickType_t ticks);
+BaseType_t xSemaphoreGive(SemaphoreHandle_t mutex);
+
+// Runs 'fn' on a detached std::thread; the stack size is ignored
+BaseType_t xTaskCreate(TaskFunction_t fn, const char* name, uint32_t stackDepth,
+                       void* arg, int priority, TaskHandle_t* handle);
+// The thread ends when its function returns, so this only has to return
+void vTaskDelete(TaskHandle_t task);
+void vTaskDelay(TickType_t ticks);
+
+#endif
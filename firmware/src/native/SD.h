@@ -0,0 +1,45 @@
+#ifndef NATIVE_SD_H
+#define NATIVE_SD_H
+
+// SD card backed by a host directory (native environment only)
+
+#include <stdint.h>
+#include <stdio.h>
+#include <memory>
+#include <string>
+
+#define FILE_READ "rb"
+
+class File {
+public:
+    File() {}
+    explicit File(FILE* f) { if (f) _f.reset(f, fclose); }
+
+    explicit operator bool() const { return _f != nullptr; }
+    size_t read(uint8_t* buf, size_t len) { return _f ? fread(buf, 1, len, _f.get()) : 0; }
+    bool seek(uint64_t pos) { return _f && fseeko(_f.get(), (off_t)pos, SEEK_SET) == 0; }
+    size_t position() { return _f ? (size_t)ftello(_f.get()) : 0; }
+    size_t size();
+    void close() { _f.reset(); }
+
+private:
+    // Copies share the handle, like the Arduino File
+    std::shared_ptr<FILE> _f;
+};
+
+class SDClass {
+public:
+    // Directory that stands in for the card root
+    bool begin(const char* root);
+
+    File open(const char* path, const char* mode = FILE_READ);
+    bool exists(const char* path);
+
+private:
+    std::string _root = ".";
+    std::string resolve(const char* path) const;
+};
+
+extern SDClass SD;
+
+#endif
@@ -0,0 +1,23 @@
+#ifndef NATIVE_LGFX_FONTS_HPP
+#define NATIVE_LGFX_FONTS_HPP
+
+// Adafruit GFX font structures as LovyanGFX declares them, so Arial.h
+// compiles on the host (native environment only)
+
+#include <Arduino.h>
+
+struct GFXglyph {
+    uint32_t bitmapOffset;
+    uint8_t width, height;
+    uint8_t xAdvance;
+    int8_t xOffset, yOffset;
+};
+
+struct GFXfont {
+    uint8_t* bitmap;
+    GFXglyph* glyph;
+    uint16_t first, last;
+    uint8_t yAdvance;
+};
+
+#endif
@@ -0,0 +1,269 @@
+// Host front end for the engine (native environment):
+//
+//   program <card dir> search <prefix> [limit]
+//   program <card dir> load <title> [--raw]
+//   program <card dir> random
+//   program <card dir> bench-search [limit] [seekUs readUs KB/s]
+//   program <card dir> bench-load [limit]
+//   program <card dir> bench-frames [articles]
+//   program <card dir> make-index <entries>
+//   program - clean-stream
+//
+// <card dir> holds wiki.idx, wiki.dat.* and optionally wiki.dict, as on
+// the SD card. Timings go to stderr, article text to stdout.
+// bench-frames renders the UI's screens into the host framebuffer.
+// make-index writes a synthetic wiki.idx (no data) for scaling search.
+// clean-stream runs cleanWikiText over framed articles for
+// tools/clean_bench.py: "<bytes>\n<article>" in, "<ns> <bytes>\n<cleaned>" out.
+
+#include <M5Cardputer.h>
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include "../WikiEngine.h"
+#include "../WikiText.h"
+#include "../SearchBench.h"
+#include "../FrameBench.h"
+#include "../UI.h"
+
+// Same size as the UI's article buffer on the device
+static const uint32_t ARTICLE_BUF_SIZE = 147456;
+
+static int usage(const char* prog) {
+    fprintf(stderr, "usage: %s <card dir> search <prefix> [limit]\n", prog);
+    fprintf(stderr, "       %s <card dir> load <title> [--raw]\n", prog);
+    fprintf(stderr, "       %s <card dir> random\n", prog);
+    fprintf(stderr, "       %s <card dir> bench-search [limit] [seekUs readUs KB/s]\n", prog);
+    fprintf(stderr, "       %s <card dir> bench-load [limit]\n", prog);
+    fprintf(stderr, "       %s <card dir> bench-frames [articles]\n", prog);
+    fprintf(stderr, "       %s <card dir> make-index <entries>\n", prog);
+    fprintf(stderr, "       %s - clean-stream\n", prog);
+    return 2;
+}
+
+// Title stems of the synthetic index: the bench traces plus common words,
+// so every keystroke of a trace lands among real neighbours
+static const char* const EXTRA_STEMS[] = {
+    "Abbey Road", "Africa", "Amsterdam", "Astronomy", "Bach", "Battle of Hastings",
+    "Biology", "Chemistry", "Chess", "Dinosaur", "Economics", "Football",
+    "Geography", "Jazz", "Linux", "Mathematics", "Moon", "Music", "Opera",
+    "Physics", "Roman Empire", "Solar System", "Tokyo", "Volcano",
+    "Азия", "Байкал", "Волга", "География", "Животные", "История России",
+    "Космос", "Литература", "Математика", "Музыка", "Новосибирск", "Физика",
+    "Футбол", "Химия", "Шахматы", "Экономика",
+};
+
+// Titles are "<stem> <zero padded number>". Stems are ordered by "<stem> "
+// and none may be a prefix of another, so the titles come out in index
+// order without sorting millions of strings.
+static int makeIndex(const char* dir, uint32_t entries) {
+    std::vector<std::string> keys;
+    for (int t = 0; t < SEARCH_TRACE_COUNT; t++) {
+        for (int e = 0; e < SEARCH_TRACES[t].count; e++) keys.push_back(std::string(SEARCH_TRACES[t].entries[e]) + " ");
+    }
+    for (const char* stem : EXTRA_STEMS) keys.push_back(std::string(stem) + " ");
+    std::sort(keys.begin(), keys.end());
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+    std::vector<std::string> stems;
+    for (size_t i = 0; i < keys.size(); i++) {
+        if (i + 1 < keys.size() && keys[i + 1].compare(0, keys[i].size(), keys[i]) == 0) continue;
+        if (keys[i].size() + 10 > TITLE_LIMIT - 1) continue; // No room for the number
+        stems.push_back(keys[i]);
+    }
+
+    uint32_t perStem = (entries + stems.size() - 1) / stems.size();
+    int digits = snprintf(nullptr, 0, "%u", perStem > 0 ? perStem - 1 : 0);
+
+    std::string path = std::string(dir) + "/wiki.idx";
+    FILE* f = fopen(path.c_str(), "wb");
+    if (!f) {
+        fprintf(stderr, "Cannot write %s\n", path.c_str());
+        return 1;
+    }
+    uint32_t written = 0;
+    for (size_t s = 0; s < stems.size() && written < entries; s++) {
+        for (uint32_t n = 0; n < perStem && written < entries; n++, written++) {
+            uint8_t record[INDEX_RECORD_SIZE] = {0};
+            snprintf((char*)record, TITLE_LIMIT, "%s%0*u", stems[s].c_str(), digits, n);
+            uint64_t offset = 0;
+            uint32_t length = 0;
+            memcpy(record + TITLE_LIMIT, &offset, 8);
+            memcpy(record + TITLE_LIMIT + 8, &length, 4);
+            fwrite(record, 1, sizeof(record), f);
+        }
+    }
+    fclose(f);
+    fprintf(stderr, "Wrote %u entries (%u stems) to %s\n", written, (unsigned)stems.size(), path.c_str());
+    return 0;
+}
+
+static int benchSearch(WikiEngine& engine, int argc, char** argv) {
+    int limit = argc >= 4 ? atoi(argv[3]) : 100;
+    SdLatencyModel sd;
+    if (argc >= 7) {
+        sd.seekUs = atoi(argv[4]);
+        sd.readUs = atoi(argv[5]);
+        sd.bytesPerMs = atoi(argv[6]) * 1024 / 1000;
+    }
+    fprintf(stderr, "SD model: seek %uus, read %uus, %u bytes/ms\n", sd.seekUs, sd.readUs, sd.bytesPerMs);
+
+    for (int t = 0; t < SEARCH_TRACE_COUNT; t++) {
+        SearchBenchReport r = benchSearchTrace(engine, SEARCH_TRACES[t], limit, sd);
+        char line[256];
+        formatSearchReport(r, engine.getEntryCount(), line, sizeof(line));
+        printf("%s\n", line);
+    }
+    return 0;
+}
+
+// Loads up to 'limit' articles spread evenly over the index through
+// loadArticleAt, as the reader does. Decode time is taken inside the
+// engine (OpenStats), so the unzip task's polling delay does not count.
+// One key=value line for tools/codec_bench.py.
+static int benchLoad(WikiEngine& engine, int argc, char** argv) {
+    uint32_t total = engine.getEntryCount();
+    uint32_t limit = argc >= 4 ? strtoul(argv[3], nullptr, 10) : total;
+    if (limit == 0 || limit > total) limit = total;
+
+    char* buffer = (char*)malloc(ARTICLE_BUF_SIZE);
+    if (!buffer) return 1;
+
+    uint32_t articles = 0, failed = 0, tooLarge = 0, inPlace = 0;
+    uint64_t bytesIn = 0, bytesOut = 0, readUs = 0, inflateUs = 0;
+    uint32_t worstUs = 0;
+    for (uint32_t n = 0; n < limit; n++) {
+        WikiIndexEntry entry;
+        if (!engine.getEntry((uint64_t)n * total / limit, &entry)) break;
+        // The reader refuses these too; counted apart, not as failures
+        if ((entry.offset >> OFFSET_SIZE_SHIFT) >= ARTICLE_BUF_SIZE) {
+            tooLarge++;
+            continue;
+        }
+        engine.loadArticleAt(entry.offset, entry.length, buffer, ARTICLE_BUF_SIZE);
+
+        const WikiEngine::OpenStats& o = engine.getLastOpen();
+        articles++;
+        if (!o.ok) {
+            failed++;
+            fprintf(stderr, "failed: %s: %s\n", entry.title, buffer);
+            continue;
+        }
+        bytesIn += o.bytesIn;
+        bytesOut += o.bytesOut;
+        readUs += o.readUs;
+        inflateUs += o.inflateUs;
+        if (o.inflateUs > worstUs) worstUs = o.inflateUs;
+        if (o.inPlace) inPlace++;
+    }
+    free(buffer);
+
+    printf("articles=%u failed=%u too_large=%u in=%llu out=%llu read_us=%llu inflate_us=%llu worst_us=%u in_place=%u\n",
+           articles, failed, tooLarge, (unsigned long long)bytesIn, (unsigned long long)bytesOut,
+           (unsigned long long)readUs, (unsigned long long)inflateUs, worstUs, inPlace);
+    return failed ? 1 : 0;
+}
+
+// Same screens and steps as the device's bench env, drawn by the software
+// LovyanGFX in NativeGfx.h
+static int benchScreens(WikiEngine& engine, int argc, char** argv) {
+    uint32_t articles = argc >= 4 ? strtoul(argv[3], nullptr, 10) : 50;
+    UI ui;
+    ui.begin();
+
+    FrameBenchReport r = benchFrames(engine, ui, articles);
+    printf("bench frames: %u articles, %u failed to load\n", r.articles, r.failed);
+    for (int k = 0; k < FRAME_KINDS; k++) {
+        char line[128];
+        formatFrameReport(r, k, line, sizeof(line));
+        printf("%s\n", line);
+    }
+    return r.failed ? 1 : 0;
+}
+
+static int cleanStream() {
+    std::vector<char> buf;
+    unsigned long len;
+    while (scanf("%lu", &len) == 1 && getchar() == '\n') {
+        buf.resize(len + 1);
+        if (fread(buf.data(), 1, len, stdin) != len) return 1;
+        buf[len] = 0;
+
+        auto start = std::chrono::steady_clock::now();
+        cleanWikiText(buf.data());
+        auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start).count();
+
+        size_t out = strlen(buf.data());
+        printf("%lld %u\n", (long long)ns, (unsigned)out);
+        fwrite(buf.data(), 1, out, stdout);
+    }
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 3) return usage(argv[0]);
+
+    if (String(argv[2]) == "clean-stream") return cleanStream();
+
+    if (String(argv[2]) == "make-index") {
+        if (argc < 4) return usage(argv[0]);
+        return makeIndex(argv[1], strtoul(argv[3], nullptr, 10));
+    }
+
+    SD.begin(argv[1]);
+    WikiEngine engine;
+    unsigned long t0 = micros();
+    if (!engine.begin()) {
+        fprintf(stderr, "No usable wiki.idx in %s\n", argv[1]);
+        return 1;
+    }
+    fprintf(stderr, "begin: %lu us\n", micros() - t0);
+
+    String cmd(argv[2]);
+    if (cmd == "search" && argc >= 4) {
+        int limit = argc >= 5 ? atoi(argv[4]) : 10;
+        t0 = micros();
+        std::vector<String> results = engine.search(argv[3], limit);
+        fprintf(stderr, "search: %lu us, %u results\n", micros() - t0, (unsigned)results.size());
+        for (const String& r : results) printf("%s\n", r.c_str());
+        return 0;
+    }
+
+    if (cmd == "bench-search") return benchSearch(engine, argc, argv);
+    if (cmd == "bench-load") return benchLoad(engine, argc, argv);
+    if (cmd == "bench-frames") return benchScreens(engine, argc, argv);
+
+    if ((cmd == "load" && argc >= 4) || cmd == "random") {
+        char* buffer = (char*)malloc(ARTICLE_BUF_SIZE);
+        if (!buffer) return 1;
+
+        bool raw = argc >= 5 && String(argv[4]) == "--raw";
+        uint32_t len;
+        t0 = micros();
+        if (cmd == "random") {
+            String title;
+            len = engine.loadRandom(buffer, ARTICLE_BUF_SIZE, title) ? strlen(buffer) : 0;
+            fprintf(stderr, "title: %s\n", title.c_str());
+        } else {
+            len = engine.loadArticle(argv[3], buffer, ARTICLE_BUF_SIZE);
+        }
+        unsigned long loadUs = micros() - t0;
+
+        t0 = micros();
+        if (!raw) cleanWikiText(buffer);
+        unsigned long cleanUs = micros() - t0;
+
+        fprintf(stderr, "load: %lu us, %u bytes; clean: %lu us, %u bytes\n",
+                loadUs, len, cleanUs, (unsigned)strlen(buffer));
+        const WikiEngine::OpenStats& o = engine.getLastOpen();
+        fprintf(stderr, "  lookup %u open %u seek %u read %u inflate %u us; codec %u%s, %u -> %u bytes\n",
+                o.lookupUs, o.openUs, o.seekUs, o.readUs, o.inflateUs,
+                o.codec, o.inPlace ? " in place" : "", o.bytesIn, o.bytesOut);
+        fwrite(buffer, 1, strlen(buffer), stdout);
+        putchar('\n');
+        free(buffer);
+        return 0;
+    }
+
+    return usage(argv[0]);
+}
@@ -0,0 +1,231 @@
+import argparse
+import collections
+import os
+import random
+import re
+import subprocess
+import sys
+
+import converter
+
+# Runs the device's cleanWikiText (firmware/src/WikiText.cpp, through the
+# native build's clean-stream command) over raw wikitext and reports:
+#   - throughput and the slowest articles,
+#   - how far its output is from a reference cleaner, by words,
+#   - with --fuzz, adversarial inputs at two sizes: time growing much
+#     faster than the input means a quadratic path, and output longer than
+#     the input or a crash means an overrun. Build the native program with
+#     -fsanitize=address to have overruns caught where they happen.
+#
+#   cd firmware && pio run -e native
+#   python tools/clean_bench.py --xml enwiki-pages-articles.xml --limit 5000
+#   python tools/clean_bench.py --synthetic 2000 --fuzz
+
+DEFAULT_NATIVE = os.path.join(os.path.dirname(os.path.abspath(__file__)),
+                              "..", "firmware", ".pio", "build", "native", "program")
+
+# Largest article the device cleans (the UI's article buffer, minus the NUL)
+MAX_ARTICLE = 147456 - 1
+
+WORD = re.compile(r"\w+")
+
+# Markup that should not survive cleaning
+RESIDUE = ["{{", "}}", "[[", "]]", "<ref", "</ref>", "{|", "|}", "<!--", "'''"]
+
+class CleanerHang(Exception):
+    pass
+
+def run_cleaner(native, articles, timeout=None):
+    """[(ns, cleaned bytes)] for each raw article (bytes), in order."""
+    framed = b"".join(str(len(a)).encode() + b"\n" + a for a in articles)
+    try:
+        proc = subprocess.run([native, "-", "clean-stream"], input=framed, capture_output=True, timeout=timeout)
+    except subprocess.TimeoutExpired:
+        raise CleanerHang(f"no result within {timeout} s")
+    if proc.returncode != 0:
+        raise RuntimeError(f"{native} clean-stream exited with {proc.returncode} "
+                           f"({proc.stderr.decode(errors='replace').strip()[-300:]})")
+    out = proc.stdout
+    results = []
+    pos = 0
+    while pos < len(out):
+        eol = out.index(b"\n", pos)
+        ns, size = (int(x) for x in out[pos:eol].split())
+        results.append((ns, out[eol + 1:eol + 1 + size]))
+        pos = eol + 1 + size
+    if len(results) != len(articles):
+        raise RuntimeError(f"clean-stream returned {len(results)} of {len(articles)} articles")
+    return results
+
+def iter_xml(path, limit):
+    with open(path, "rb") as f:
+        for title, raw_text, _ in converter.iter_pages(f, namespaces={'0'}):
+            yield title, raw_text
+            limit -= 1
+            if limit == 0:
+                return
+
+def iter_synthetic(count, seed):
+    import gen_dataset
+    gen = gen_dataset.Generator(seed, 0.5, 0.0)
+    for _, ns, title, text, redirect in gen.pages(count):
+        if ns == 0 and not redirect:
+            yield title, text
+
+def word_overlap(device, reference):
+    """Share of words the two outputs agree on, as multisets (1.0 = same words)."""
+    a = collections.Counter(WORD.findall(device.lower()))
+    b = collections.Counter(WORD.findall(reference.lower()))
+    total = max(sum(a.values()), sum(b.values()))
+    if total == 0:
+        return 1.0
+    return sum((a & b).values()) / total
+
+def percentile(sorted_values, p):
+    if not sorted_values:
+        return 0
+    return sorted_values[min(len(sorted_values) - 1, int(len(sorted_values) * p))]
+
+def corpus_report(native, pages, show):
+    titles = []
+    raws = []
+    for title, text in pages:
+        raw = text.encode("utf-8")[:MAX_ARTICLE]
+        titles.append(title)
+        raws.append(raw)
+    if not raws:
+        sys.exit("No articles")
+
+    results = run_cleaner(native, raws)
+    total_bytes = sum(len(r) for r in raws)
+    total_ns = sum(ns for ns, _ in results)
+    times = sorted(ns for ns, _ in results)
+    print(f"{len(raws)} articles, {total_bytes / 2**20:.1f} MB raw wikitext")
+    print(f"cleanWikiText: {total_bytes / 2**20 / (total_ns / 1e9):.1f} MB/s, "
+          f"per article p50 {percentile(times, 0.5) / 1000:.1f} us, p99 {percentile(times, 0.99) / 1000:.1f} us, "
+          f"max {times[-1] / 1000:.1f} us")
+
+    slowest = sorted(range(len(raws)), key=lambda i: results[i][0], reverse=True)[:show]
+    print("Slowest:")
+    for i in slowest:
+        ns = results[i][0]
+        print(f"  {ns / 1000:9.1f} us  {len(raws[i]):7d} B  {ns / max(len(raws[i]), 1):6.1f} ns/B  {titles[i]}")
+
+    # Reference: the converter's cleaner, which the card text went through. It
+    # drops nested templates, tables and comments whole, so markup left over or
+    # words lost are the device's
+    overlaps = []
+    residue_device = collections.Counter()
+    residue_reference = collections.Counter()
+    for i, raw in enumerate(raws):
+        text = raw.decode("utf-8", errors="replace")
+        reference = converter.clean_wiki_text(text) or ""
+        device = results[i][1].decode("utf-8", errors="replace")
+        overlaps.append((word_overlap(device, reference), i))
+        for token in RESIDUE:
+            residue_device[token] += device.count(token)
+            residue_reference[token] += reference.count(token)
+
+    mean = sum(o for o, _ in overlaps) / len(overlaps)
+    print(f"Word overlap with the reference cleaner: mean {mean:.3f}, "
+          f"min {min(overlaps)[0]:.3f}")
+    print("Leftover markup (device / reference):")
+    print("  " + "  ".join(f"{t} {residue_device[t]}/{residue_reference[t]}" for t in RESIDUE))
+    print("Least similar:")
+    for overlap, i in sorted(overlaps)[:show]:
+        print(f"  {overlap:.3f}  {titles[i]}")
+
+# Adversarial inputs, as functions of a target size in bytes
+FUZZ_CASES = {
+    "unclosed {{":       lambda n: "{{" + "x" * (n - 2),
+    "many {{":           lambda n: "{{a " * (n // 4),
+    "many <ref":         lambda n: "<ref name=x>t " * (n // 14),
+    "<ref no >":         lambda n: "<ref " * (n // 5),
+    "many [[ one line":  lambda n: "[[a " * (n // 4),
+    "stray <":           lambda n: "a < b " * (n // 6),
+    "<table unclosed":   lambda n: "<table x " * (n // 9),
+    "loose </":          lambda n: "</" * (n // 2),
+    "unclosed <!--":     lambda n: "<!--" + "-" * (n - 4),
+    "nested {|":         lambda n: "{|" * (n // 2),
+    "[[File: unclosed":  lambda n: "[[File:" + "[[" * ((n - 7) // 2),
+    "quotes":            lambda n: "'" * n,
+    "underscores":       lambda n: "_" * n,
+}
+
+FUZZ_TOKENS = ["{{", "}}", "{|", "|}", "[[", "]]", "[[File:", "[[Category:", "|", "<ref", "<ref name=a/>",
+               "</ref>", "<", ">", "</", "/>", "<!--", "-->", "<table ", "</table>", "<div>", "<gallery>",
+               "'''", "''", "__TOC__", "__", "\n", " ", "word", "слово"]
+
+def random_markup(rng, n):
+    out = []
+    size = 0
+    while size < n:
+        t = rng.choice(FUZZ_TOKENS)
+        out.append(t)
+        size += len(t.encode("utf-8"))
+    return "".join(out).encode("utf-8")[:n]
+
+# Seconds one fuzz run may take before it counts as a hang
+FUZZ_TIMEOUT = 10
+
+def fuzz_report(native, seed, rounds):
+    small, large = 16 * 1024, 64 * 1024
+    ok = True
+    print(f"Fuzz: {len(FUZZ_CASES)} patterns at {small // 1024} and {large // 1024} KB, "
+          f"{rounds} random markup soups")
+
+    for name, make in FUZZ_CASES.items():
+        cases = [make(small).encode("utf-8"), make(large).encode("utf-8")]
+        try:
+            # Best of 3 runs, so a scheduler hiccup does not read as a blowup
+            runs = [run_cleaner(native, cases, FUZZ_TIMEOUT) for _ in range(3)]
+        except (CleanerHang, RuntimeError) as e:
+            ok = False
+            print(f"  FAIL  {name:18s} {e}")
+            continue
+        t_small = min(r[0][0] for r in runs)
+        t_large = min(r[1][0] for r in runs)
+        growth = t_large / max(t_small, 1)
+        grew = any(len(runs[0][j][1]) > len(cases[j]) for j in (0, 1))
+        # 4x the input: linear is ~4x, quadratic ~16x
+        bad = growth > 8 or grew
+        ok &= not bad
+        print(f"  {'FAIL' if bad else 'ok  '}  {name:18s} {t_small / 1000:8.1f} us -> {t_large / 1000:8.1f} us "
+              f"(x{growth:.1f}){'  output grew' if grew else ''}")
+
+    rng = random.Random(seed)
+    soups = [random_markup(rng, rng.randint(1, MAX_ARTICLE)) for _ in range(rounds)]
+    try:
+        results = run_cleaner(native, soups, FUZZ_TIMEOUT * rounds)
+    except (CleanerHang, RuntimeError) as e:
+        print(f"  FAIL  random soups: {e}")
+        return False
+    worst = max((ns / max(len(s), 1), i) for i, ((ns, _), s) in enumerate(zip(results, soups)))
+    grew = sum(1 for (_, out), s in zip(results, soups) if len(out) > len(s))
+    ok &= grew == 0
+    print(f"  {'FAIL' if grew else 'ok  '}  random soups: worst {worst[0]:.1f} ns/B "
+          f"({len(soups[worst[1]])} B), {grew} outputs longer than their input")
+    return ok
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description="Throughput, reference comparison and fuzzing of cleanWikiText")
+    source = parser.add_mutually_exclusive_group()
+    source.add_argument("--xml", help="MediaWiki XML dump (articles namespace)")
+    source.add_argument("--synthetic", type=int, metavar="PAGES", help="Pages from gen_dataset.py instead of a dump")
+    parser.add_argument("--limit", type=int, default=5000, help="Articles to take from the dump")
+    parser.add_argument("--seed", type=int, default=1, help="Seed for --synthetic and the fuzz soups")
+    parser.add_argument("--show", type=int, default=5, help="Slowest / least similar articles to list")
+    parser.add_argument("--fuzz", action="store_true", help="Also run the adversarial inputs")
+    parser.add_argument("--fuzz-rounds", type=int, default=200, help="Random markup soups to try")
+    parser.add_argument("--native", default=DEFAULT_NATIVE, help="Engine built with 'pio run -e native'")
+    args = parser.parse_args()
+
+    if args.xml:
+        corpus_report(args.native, iter_xml(args.xml, args.limit), args.show)
+    elif args.synthetic:
+        corpus_report(args.native, iter_synthetic(args.synthetic, args.seed), args.show)
+    elif not args.fuzz:
+        parser.error("give --xml, --synthetic and/or --fuzz")
+
+    if args.fuzz and not fuzz_report(args.native, args.seed, args.fuzz_rounds):
+        sys.exit(1)
@@ -0,0 +1,163 @@
+import argparse
+import os
+import random
+import shutil
+import subprocess
+import tempfile
+import time
+import zlib
+
+import converter
+
+# Codec / level / window matrix over a sample of a built data set. Each
+# candidate is compressed here (ratio, compression speed) and written as a
+# small card image, which the native build of the engine then loads
+# article by article through loadArticleAt (decode speed, in-place share):
+#
+#   cd firmware && pio run -e native
+#   python tools/codec_bench.py <card dir> --native firmware/.pio/build/native/program
+#
+# The native build decodes with the device's tinfl and LZ4 code, so decode
+# speeds rank deflate against LZ4 as the device would; the absolute numbers
+# are the host's.
+
+# Largest article the device opens (the UI's article buffer, minus the NUL)
+MAX_ARTICLE = 147456 - 1
+
+DEFAULT_NATIVE = os.path.join(os.path.dirname(os.path.abspath(__file__)),
+                              "..", "firmware", ".pio", "build", "native", "program")
+
+def sample_articles(card_dir, count, seed):
+    """[(title bytes, article bytes)] in index order, the card's dictionary, and how
+    many picks were dropped for being larger than the device opens."""
+    zdict = None
+    dict_path = os.path.join(card_dir, converter.DICT_NAME)
+    if os.path.exists(dict_path):
+        with open(dict_path, "rb") as f:
+            zdict = f.read()
+
+    with open(os.path.join(card_dir, "wiki.idx"), "rb") as f:
+        index = f.read()
+    record = converter.INDEX_RECORD
+    total = len(index) // record.size
+    picks = sorted(random.Random(seed).sample(range(total), min(count, total)))
+
+    shards = {}
+    articles = []
+    skipped = 0
+    for i in picks:
+        title, packed, length = record.unpack_from(index, i * record.size)
+        file_index, local_offset, codec, size = converter.unpack_offset(packed)
+        f = shards.get(file_index)
+        if f is None:
+            f = shards[file_index] = open(os.path.join(card_dir, f"wiki.dat.{file_index:03d}"), "rb")
+        f.seek(local_offset)
+        data = converter.decompress_article(codec, f.read(length), size, zdict)
+        if len(data) > MAX_ARTICLE:
+            skipped += 1
+            continue
+        articles.append((title, data))
+    for f in shards.values():
+        f.close()
+    return articles, zdict, skipped
+
+def compress(data, codec, level, wbits, zdict):
+    if codec == converter.CODEC_LZ4:
+        return converter.lz4_compress_block(data)
+    if codec == converter.CODEC_RAW_DEFLATE_DICT:
+        c = zlib.compressobj(level=level, wbits=-wbits, zdict=zdict)
+    else:
+        c = zlib.compressobj(level=level, wbits=-wbits)
+    return c.compress(data) + c.flush()
+
+def build_candidate(articles, codec, level, wbits, zdict, out_dir):
+    """Writes the sample as a card with one codec setting. (compressed bytes, seconds)"""
+    spent = 0.0
+    stored = 0
+    with open(os.path.join(out_dir, "wiki.dat.000"), "wb") as dat, \
+         open(os.path.join(out_dir, "wiki.idx"), "wb") as idx:
+        for title, data in articles:
+            start = time.perf_counter()
+            blob = compress(data, codec, level, wbits, zdict)
+            spent += time.perf_counter() - start
+            stored += len(blob)
+
+            # As converter.py stores it: in-place safe, or stored blocks
+            blob_codec, blob = converter.fit_in_place(codec, blob, data, zdict)
+            idx.write(converter.INDEX_RECORD.pack(title, converter.pack_offset(0, dat.tell(), blob_codec, len(data)), len(blob)))
+            dat.write(blob)
+    if codec == converter.CODEC_RAW_DEFLATE_DICT:
+        converter.write_dictionary(out_dir, zdict)
+    return stored, spent
+
+def run_native(native, card_dir):
+    proc = subprocess.run([native, card_dir, "bench-load"], capture_output=True, text=True)
+    fields = {}
+    for line in proc.stdout.splitlines():
+        if line.startswith("articles="):
+            fields = {k: int(v) for k, v in (item.split("=") for item in line.split())}
+    if proc.returncode != 0 or not fields:
+        raise RuntimeError(f"{native} bench-load failed: {proc.stderr.strip()[-500:]}")
+    return fields
+
+def candidates(levels, windows, zdict):
+    for level in levels:
+        for wbits in windows:
+            yield "deflate", converter.CODEC_RAW_DEFLATE, level, wbits
+            if zdict:
+                yield "deflate+dict", converter.CODEC_RAW_DEFLATE_DICT, level, wbits
+    yield "lz4", converter.CODEC_LZ4, None, None
+
+def mb_per_s(nbytes, seconds):
+    return nbytes / 2**20 / seconds if seconds > 0 else float('inf')
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description="Compare codecs, levels and windows on a sample of a data set")
+    parser.add_argument("card_dir", help="Built data set (wiki.idx, wiki.dat.*, optional wiki.dict)")
+    parser.add_argument("--sample", type=int, default=300, help="Articles to sample")
+    parser.add_argument("--seed", type=int, default=1, help="Sampling seed")
+    parser.add_argument("--levels", default="1,6,9", help="zlib levels, comma separated")
+    parser.add_argument("--wbits", default="15", help="Deflate window bits (9-15), comma separated")
+    parser.add_argument("--dict-file", help="Preset dictionary for the deflate+dict rows (default: the card's)")
+    parser.add_argument("--native", default=DEFAULT_NATIVE, help="Engine built with 'pio run -e native'")
+    parser.add_argument("--csv", help="Also write the table as CSV")
+    args = parser.parse_args()
+
+    articles, zdict, skipped = sample_articles(args.card_dir, args.sample, args.seed)
+    if args.dict_file:
+        with open(args.dict_file, "rb") as f:
+            zdict = f.read()
+    raw = sum(len(data) for _, data in articles)
+    print(f"{len(articles)} articles, {raw / 2**20:.2f} MB uncompressed"
+          + (f", {len(zdict)} byte dictionary" if zdict else "")
+          + (f", {skipped} skipped as too large to open" if skipped else ""))
+    if converter.lz4 is None:
+        print("lz4 module missing: LZ4 compression speed is the pure-Python matcher's")
+
+    header = ["codec", "level", "wbits", "ratio", "comp MB/s", "dec MB/s", "worst ms", "in place"]
+    rows = []
+    for name, codec, level, wbits in candidates([int(x) for x in args.levels.split(",")],
+                                                [int(x) for x in args.wbits.split(",")], zdict):
+        work = tempfile.mkdtemp(prefix="codec_bench_")
+        try:
+            stored, spent = build_candidate(articles, codec, level, wbits, zdict, work)
+            r = run_native(args.native, work)
+        finally:
+            shutil.rmtree(work)
+        rows.append([name, "-" if level is None else str(level), "-" if wbits is None else str(wbits),
+                     f"{raw / stored:.2f}",
+                     f"{mb_per_s(raw, spent):.1f}",
+                     f"{mb_per_s(r['out'], r['inflate_us'] / 1e6):.1f}",
+                     f"{r['worst_us'] / 1000:.2f}",
+                     f"{100 * r['in_place'] // max(r['articles'], 1)}%"])
+
+    widths = [max(len(h), *(len(row[i]) for row in rows)) for i, h in enumerate(header)]
+    print("  ".join(h.rjust(w) for h, w in zip(header, widths)))
+    for row in rows:
+        print("  ".join(c.rjust(w) for c, w in zip(row, widths)))
+
+    if args.csv:
+        with open(args.csv, "w") as f:
+            f.write(",".join(header) + "\n")
+            for row in rows:
+                f.write(",".join(row) + "\n")
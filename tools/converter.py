@@ -5,12 +5,82 @@ import re
 import os
 import argparse
 import bz2
+import collections
+import multiprocessing
+import heapq
+import tempfile
+import io
+import sys
+import hashlib
+import shutil
+# Optional (pip install lz4): fast LZ4 compression. Without it
+# lz4_compress_block falls back to a pure-Python matcher.
+try:
+    import lz4.block
+except ImportError:
+    lz4 = None
 
 # --- Configuration ---
 # Minimum article length to include (compressed bytes approx)
 MIN_ARTICLE_SIZE = 50 
 # Skip redirection pages
 SKIP_REDIRECTS = True
+# Parallel pipeline: pages per worker task, and tasks in flight per worker
+PIPELINE_BATCH = 64
+PIPELINE_DEPTH = 4
+# External index sort: rough bytes per in-memory entry on top of the title,
+# and how many runs are merged at once
+SORT_ENTRY_OVERHEAD = 160
+SORT_MAX_FANIN = 128
+# Preset deflate dictionary (firmware PRESET_DICT_SIZE): trained on the
+# first articles of the dump, stored on the card as wiki.dict
+DICT_NAME = "wiki.dict"
+# Adler-32 of the dictionary the data was compressed against, as 8 hex
+# digits. Written with the index, so the device can tell a stale wiki.dict
+# from the right one before it inflates codec 3 records to garbage.
+DICT_ID_NAME = "wiki.dictid"
+DICT_SIZE = 32 * 1024
+DICT_SAMPLE_BYTES = 4 * 1024 * 1024
+DICT_KMER = 8
+DICT_SEGMENT = 64
+# Packed offset (firmware WikiCodec / OFFSET_*_SHIFT): bits 0-31 offset in
+# shard, 32-39 shard, 40-43 codec, 44-63 uncompressed length (0 = unknown)
+CODEC_ZLIB = 0           # zlib stream, older builds
+CODEC_LZ4 = 1
+CODEC_RAW_DEFLATE = 2
+CODEC_RAW_DEFLATE_DICT = 3  # Raw deflate against wiki.dict
+CODEC_SHIFT = 40
+SIZE_SHIFT = 44
+FILE_INDEX_MASK = 0xFF
+SIZE_MASK = (1 << 20) - 1
+# Index record (firmware WikiIndexEntry): NUL-padded title, packed offset,
+# stored length. 64 bytes.
+TITLE_LIMIT = 52
+INDEX_RECORD = struct.Struct(f'<{TITLE_LIMIT}sQI')
+# In-place loading (firmware IN_PLACE_MARGIN): the device stages a blob at
+# the end of its buffer and decodes forward over it. No article may need
+# more than this many bytes past its decoded end for that to be safe.
+IN_PLACE_MARGIN = 4096
+IN_PLACE_CHUNK = 256
+# --codec auto: LZ4 for articles at least this long (shorter ones inflate
+# quickly anyway), as long as the blob is at most this much larger
+LZ4_MIN_SIZE = 8 * 1024
+LZ4_MAX_GROWTH = 1.6
+# Multistream input: bz2 streams (about 100 pages each) per decode task
+MULTISTREAM_GROUP = 8
+
+# Compact single-byte encoding (see firmware/src/CompactText.h)
+COMPACT_MARKER = 0x0E
+COMPACT_QUOTE = 0x02
+DEFAULT_WINDOW = 0x400 >> 7  # Cyrillic
+# Typography the device font has no glyphs for
+COMPACT_FOLD = {
+    '\u00a0': ' ',
+    '\u00ab': '"', '\u00bb': '"', '\u201c': '"', '\u201d': '"', '\u201e': '"',
+    '\u2018': "'", '\u2019': "'",
+    '\u2013': '-', '\u2014': '-',
+    '\u2026': '...',
+}
 
 def extract_intro(text):
   
@@ -36,6 +106,42 @@ def extract_intro(text):
     
     return intro
 
+# Blocks dropped with everything nested in them. Each closer names its
+# opener, so the '|}' of '{{x|}}' is not taken for the end of a table.
+BLOCK_START = re.compile(r'\{\{|\{\|')
+BLOCK_TOKENS = re.compile(r'\{\{|\{\||\|\}|\}\}')
+BLOCK_PAIRS = {'}}': '{{', '|}': '{|'}
+META_START = re.compile(r'\[\[(?:File|Image|Category):')
+LINK_TOKENS = re.compile(r'\[\[|\]\]')
+LINK_PAIRS = {']]': '[['}
+
+def strip_nested(text, start, tokens, pairs):
+    """Removes every block 'start' opens, through its balanced close. An
+    unclosed block runs to the end of the text, as on the device."""
+    out = []
+    pos = 0
+    while True:
+        m = start.search(text, pos)
+        if not m:
+            out.append(text[pos:])
+            return ''.join(out)
+        out.append(text[pos:m.start()])
+        stack = [m.group()[:2]]
+        pos = m.end()
+        while stack:
+            t = tokens.search(text, pos)
+            if not t:
+                return ''.join(out)
+            token = t.group()
+            if token not in pairs:
+                stack.append(token)
+                pos = t.end()
+            elif pairs[token] == stack[-1]:
+                stack.pop()
+                pos = t.end()
+            else:
+                pos = t.start() + 1
+
 def clean_wiki_text(text, only_intro=False):
     if not text:
         return ""
@@ -47,13 +153,18 @@ def clean_wiki_text(text, only_intro=False):
     if only_intro:
         text = extract_intro(text)
 
-    # Remove [[File:...]]
-    text = re.sub(r'\[\[File:.*?\]\]', '', text)
-    # Remove [[Image:...]]
-    text = re.sub(r'\[\[Image:.*?\]\]', '', text)
-    # Remove references <ref>...</ref>
-    text = re.sub(r'<ref.*?>.*?</ref>', '', text, flags=re.DOTALL)
-    text = re.sub(r'<ref.*?>', '', text)
+    # Remove comments <!-- ... -->, unclosed ones to the end
+    text = re.sub(r'<!--.*?(?:-->|\Z)', '', text, flags=re.DOTALL)
+    # Remove references: <ref name="x" /> on its own, <ref>...</ref> with
+    # its content, an unclosed <ref> as just the tag
+    text = re.sub(r'<ref[^>]*/>', '', text)
+    text = re.sub(r'<ref[^>]*>.*?</ref>', '', text, flags=re.DOTALL)
+    text = re.sub(r'<ref[^>]*>', '', text)
+    # Remove templates {{...}} and tables {|...|}, nested in any mix
+    text = strip_nested(text, BLOCK_START, BLOCK_TOKENS, BLOCK_PAIRS)
+    # Remove [[File:...]], [[Image:...]] (links in the caption included)
+    # and [[Category:...]]
+    text = strip_nested(text, META_START, LINK_TOKENS, LINK_PAIRS)
     
     # Simplify links [[Page|Text]] -> Text
     text = re.sub(r'\[\[(?:[^|\]]*\|)?([^\]]+)\]\]', r'\1', text)
@@ -61,36 +172,773 @@ def clean_wiki_text(text, only_intro=False):
     # Remove headers === ... ===
     text = re.sub(r'={2,}(.*?)={2,}', r'\n\1\n', text)
     
-    # Remove templates {{...}} - primitive approach
-    # Note: Recursive templates are hard with regex. This is a best-effort.
-    text = re.sub(r'\{\{.*?\}\}', '', text, flags=re.DOTALL)
-    
     # Basic cleanup
     text = text.replace("'''", "").replace("''", "")
     text = re.sub(r'\n{3,}', '\n\n', text).strip()
     
     return text
 
-def convert_xml_dump(xml_file, output_dir, only_intro=False):
+def encode_compact(text):
+    """Encodes text as [marker][window] + one byte per ASCII/window char.
+
+    The window is the 128-codepoint block holding most non-ASCII chars,
+    so a Russian article becomes one byte per letter. Anything outside
+    the window is quoted as 3 bytes of 7 bits with the top bit set.
+    """
+    text = ''.join(COMPACT_FOLD.get(ch, ch) for ch in text)
+
+    blocks = {}
+    for ch in text:
+        cp = ord(ch)
+        if cp >= 0x80:
+            blocks[cp >> 7] = blocks.get(cp >> 7, 0) + 1
+    window = max(blocks, key=blocks.get) if blocks else DEFAULT_WINDOW
+    base = window << 7
+
+    out = bytearray([COMPACT_MARKER, 0x80 | window])
+    for ch in text:
+        cp = ord(ch)
+        if 0x20 <= cp < 0x7F or cp == 0x09 or cp == 0x0A:
+            out.append(cp)
+        elif base <= cp < base + 0x80:
+            out.append(0x80 + cp - base)
+        elif cp < 0x80:
+            continue  # Other control chars
+        else:
+            out += bytes([COMPACT_QUOTE,
+                          0x80 | ((cp >> 14) & 0x7F),
+                          0x80 | ((cp >> 7) & 0x7F),
+                          0x80 | (cp & 0x7F)])
+    return bytes(out)
+
+def decode_compact(data):
+    """Inverse of encode_compact (after folding)."""
+    if len(data) < 2 or data[0] != COMPACT_MARKER:
+        return data.decode('utf-8')
+    base = (data[1] & 0x7F) << 7
+    out = []
+    i = 2
+    while i < len(data):
+        b = data[i]
+        i += 1
+        if b >= 0x80:
+            out.append(chr(base + b - 0x80))
+        elif b == COMPACT_QUOTE:
+            cp = ((data[i] & 0x7F) << 14) | ((data[i + 1] & 0x7F) << 7) | (data[i + 2] & 0x7F)
+            out.append(chr(cp))
+            i += 3
+        else:
+            out.append(chr(b))
+    return ''.join(out)
+
+def encode_article(text, encoding):
+    if encoding == 'compact':
+        return encode_compact(text)
+    return text.encode('utf-8')
+
+def iter_pages(source, namespaces=None):
+    """Parser stage: yields (title, raw_text, (key, rev_id, sha1)) per page, in dump order.
+
+    key is the page id (or the title for exports without ids) and sha1 the
+    revision hash from the dump, computed here if the dump has none.
+
+    Runs in constant memory: each field is copied out and cleared when its
+    end tag arrives, and finished pages are dropped from the root element,
+    which would otherwise keep a reference to every page.
+    """
+    context = iter(ET.iterparse(source, events=("start", "end")))
+    _, root = next(context)
+    
+    title = None
+    ns = None
+    raw_text = None
+    redirect = False
+    page_id = rev_id = sha1 = None
+    # <id> appears under <page>, <revision> and <contributor>
+    in_revision = False
+    in_contributor = False
+    
+    for event, elem in context:
+        tag = elem.tag.split('}')[-1] 
+        
+        if event == 'start':
+            if tag == 'revision':
+                in_revision = True
+            elif tag == 'contributor':
+                in_contributor = True
+            continue
+        
+        if tag == 'id':
+            if in_contributor:
+                pass
+            elif in_revision:
+                rev_id = elem.text
+            else:
+                page_id = elem.text
+        elif tag == 'sha1':
+            sha1 = elem.text
+        elif tag == 'contributor':
+            in_contributor = False
+        elif tag == 'revision':
+            in_revision = False
+        elif tag == 'title':
+            title = elem.text
+        elif tag == 'ns':
+            ns = elem.text
+        elif tag == 'redirect':
+            redirect = True
+        elif tag == 'text':
+            raw_text = elem.text
+        elif tag == 'page':
+            # Exports without <ns> only hold articles
+            page_ns = ns if ns is not None else '0'
+            skip = (redirect and SKIP_REDIRECTS) or (namespaces is not None and page_ns not in namespaces)
+            if title and raw_text and not skip:
+                key = page_id if page_id else "t:" + title
+                if not sha1:
+                    sha1 = hashlib.sha1(raw_text.encode('utf-8')).hexdigest()
+                yield title, raw_text, (key, rev_id, sha1)
+            title = ns = raw_text = None
+            page_id = rev_id = sha1 = None
+            redirect = False
+            root.clear() # drop this and earlier pages
+            continue
+        
+        elem.clear() # clear memory
+
+def report_memory():
+    """Prints the peak RSS of this process and of the largest worker."""
+    try:
+        import resource
+    except ImportError:
+        return # Not available on Windows
+    # ru_maxrss is in KB on Linux, bytes on macOS
+    scale = 1 if sys.platform == 'darwin' else 1024
+    own = resource.getrusage(resource.RUSAGE_SELF).ru_maxrss * scale
+    children = resource.getrusage(resource.RUSAGE_CHILDREN).ru_maxrss * scale
+    print(f"Peak memory: {own / 2**20:.1f} MB (main), {children / 2**20:.1f} MB (largest worker)")
+
+def compress_article(data, zdict=None):
+    """Raw deflate: the index already has the length, so no zlib header or Adler-32."""
+    if zdict is None:
+        c = zlib.compressobj(wbits=-15)
+    else:
+        c = zlib.compressobj(wbits=-15, zdict=zdict)
+    return c.compress(data) + c.flush()
+
+def lz4_compress_block(data):
+    """LZ4 block format (no frame, no size prefix), greedy matcher."""
+    if lz4 is not None:
+        return lz4.block.compress(data, store_size=False)
+
+    n = len(data)
+    out = bytearray()
+    last_match = n - 12  # A match may not start in the last 12 bytes
+    table = {}
+    anchor = 0
+    i = 0
+
+    def put_length(rest):
+        while rest >= 255:
+            out.append(255)
+            rest -= 255
+        out.append(rest)
+
+    while i < last_match:
+        seq = data[i:i + 4]
+        ref = table.get(seq)
+        table[seq] = i
+        if ref is None or i - ref > 0xFFFF:
+            i += 1
+            continue
+
+        # Extend the match, keeping the last 5 bytes as literals
+        length = 4
+        limit = n - 5 - i
+        while length < limit and data[ref + length] == data[i + length]:
+            length += 1
+
+        lit = i - anchor
+        out.append((min(lit, 15) << 4) | min(length - 4, 15))
+        if lit >= 15:
+            put_length(lit - 15)
+        out += data[anchor:i]
+        out += (i - ref).to_bytes(2, 'little')
+        if length - 4 >= 15:
+            put_length(length - 4 - 15)
+
+        i += length
+        anchor = i
+
+    lit = n - anchor
+    out.append(min(lit, 15) << 4)
+    if lit >= 15:
+        put_length(lit - 15)
+    out += data[anchor:]
+    return bytes(out)
+
+def lz4_decompress_block(blob, size):
+    """Inverse of lz4_compress_block. 'size' bounds the output."""
+    if lz4 is not None:
+        return lz4.block.decompress(blob, uncompressed_size=size)
+    out = bytearray()
+    pos = 0
+    n = len(blob)
+    while pos < n:
+        token = blob[pos]
+        pos += 1
+        lit = token >> 4
+        if lit == 15:
+            while True:
+                lit += blob[pos]
+                pos += 1
+                if blob[pos - 1] != 255:
+                    break
+        out += blob[pos:pos + lit]
+        pos += lit
+        if pos >= n:
+            break
+        offset = blob[pos] | (blob[pos + 1] << 8)
+        pos += 2
+        match = token & 15
+        if match == 15:
+            while True:
+                match += blob[pos]
+                pos += 1
+                if blob[pos - 1] != 255:
+                    break
+        for _ in range(match + 4):
+            out.append(out[-offset])
+    return bytes(out)
+
+def decompress_article(codec, blob, size, zdict=None):
+    """Article bytes of one stored record, whatever its codec. 'size' is
+    the packed offset's, 0 if unknown."""
+    if codec == CODEC_LZ4:
+        return lz4_decompress_block(blob, size or SIZE_MASK)
+    if codec == CODEC_ZLIB:
+        if blob[1] & 0x20:
+            d = zlib.decompressobj(zdict=zdict)
+        else:
+            d = zlib.decompressobj()
+        return d.decompress(blob)
+    if codec == CODEC_RAW_DEFLATE_DICT:
+        return zlib.decompressobj(wbits=-15, zdict=zdict).decompress(blob)
+    return zlib.decompressobj(wbits=-15).decompress(blob)
+
+def choose_codec(data, zdict, policy):
+    """(codec, blob) for one article under the --codec policy."""
+    if policy == 'lz4':
+        return CODEC_LZ4, lz4_compress_block(data)
+    deflated = compress_article(data, zdict)
+    deflate_codec = CODEC_RAW_DEFLATE_DICT if zdict else CODEC_RAW_DEFLATE
+    if policy == 'deflate' or len(data) < LZ4_MIN_SIZE:
+        return deflate_codec, deflated
+    fast = lz4_compress_block(data)
+    if len(fast) <= len(deflated) * LZ4_MAX_GROWTH:
+        return CODEC_LZ4, fast
+    return deflate_codec, deflated
+
+def in_place_margin(codec, blob, size, zdict=None):
+    """Upper bound on the bytes needed past the decoded article when 'blob'
+    is staged at the end of the output buffer and decoded forward over it:
+    output written plus input not yet read, minus 'size', at the worst point.
+    """
+    n = len(blob)
+    worst = n - size
+    if codec == CODEC_LZ4:
+        # Exact: walk the sequences, checking after every match
+        out = pos = 0
+        while pos < n:
+            token = blob[pos]
+            pos += 1
+            lit = token >> 4
+            if lit == 15:
+                while True:
+                    lit += blob[pos]
+                    pos += 1
+                    if blob[pos - 1] != 255:
+                        break
+            pos += lit
+            out += lit
+            if pos >= n:
+                break
+            pos += 2
+            match = token & 15
+            if match == 15:
+                while True:
+                    match += blob[pos]
+                    pos += 1
+                    if blob[pos - 1] != 255:
+                        break
+            out += match + 4
+            worst = max(worst, out + (n - pos) - size)
+    else:
+        # Fed a chunk at a time, so every chunk counts as unread until all
+        # of its output is out. Pessimistic by about one chunk's output.
+        if zdict and codec == CODEC_RAW_DEFLATE_DICT:
+            d = zlib.decompressobj(wbits=-15, zdict=zdict)
+        else:
+            d = zlib.decompressobj(wbits=-15)
+        out = 0
+        for start in range(0, n, IN_PLACE_CHUNK):
+            out += len(d.decompress(blob[start:start + IN_PLACE_CHUNK]))
+            worst = max(worst, out + (n - start) - size)
+    return max(worst, 0)
+
+def fit_in_place(codec, blob, data, zdict):
+    """Falls back to stored deflate blocks (never ahead of their input) when
+    the blob could overrun itself in place."""
+    if len(blob) <= IN_PLACE_MARGIN:
+        return codec, blob  # The margin can never exceed the blob size
+    if in_place_margin(codec, blob, len(data), zdict) <= IN_PLACE_MARGIN:
+        return codec, blob
+    c = zlib.compressobj(level=0, wbits=-15)
+    return CODEC_RAW_DEFLATE, c.compress(data) + c.flush()
+
+def pack_offset(file_index, local_offset, codec, size=0):
+    if size > SIZE_MASK:
+        size = 0  # Too long to record; the device falls back to its buffer size
+    return (size << SIZE_SHIFT) | (codec << CODEC_SHIFT) | (file_index << 32) | local_offset
+
+def unpack_offset(packed):
+    """(file_index, local_offset, codec, size)"""
+    return ((packed >> 32) & FILE_INDEX_MASK, packed & 0xFFFFFFFF,
+            (packed >> CODEC_SHIFT) & 0xF, packed >> SIZE_SHIFT)
+
+def prepare_article(raw_text, only_intro, encoding):
+    """Cleaned and encoded article bytes, or None if the page is skipped."""
+    clean_text = clean_wiki_text(raw_text, only_intro)
+    if clean_text and len(clean_text) > MIN_ARTICLE_SIZE:
+        return encode_article(clean_text, encoding)
+    return None
+
+def process_page(raw_text, only_intro, encoding, zdict=None, codec='deflate'):
+    """Worker stage: clean and compress one page. (codec, blob, size), or None if it is skipped."""
+    data = prepare_article(raw_text, only_intro, encoding)
+    if data is None:
+        return None
+    blob_codec, blob = choose_codec(data, zdict, codec)
+    return fit_in_place(blob_codec, blob, data, zdict) + (len(data),)
+
+def process_batch(batch, only_intro, encoding, zdict=None, codec='deflate'):
+    return [(title, process_page(raw_text, only_intro, encoding, zdict, codec) if raw_text is not None else None, meta)
+            for title, raw_text, meta in batch]
+
+def train_dictionary(samples, size=DICT_SIZE, k=DICT_KMER, segment=DICT_SEGMENT):
+    """Builds a deflate preset dictionary from frequent substrings of samples.
+
+    Every k-gram is scored by how many samples contain it. Segments of the
+    samples are then picked greedily by the total score of k-grams not yet
+    covered. The best segments go last, where deflate distances are
+    shortest.
+    """
+    freq = collections.Counter()
+    for data in samples:
+        freq.update({data[i:i + k] for i in range(len(data) - k + 1)})
+
+    def score(seg, covered):
+        grams = {seg[i:i + k] for i in range(len(seg) - k + 1)}
+        return sum(freq[g] for g in grams if freq[g] > 1 and g not in covered)
+
+    heap = []
+    for data in samples:
+        for start in range(0, max(len(data) - segment, 0) + 1, segment // 2):
+            seg = data[start:start + segment]
+            s = score(seg, ())
+            if s:
+                heap.append((-s, len(heap), seg))
+    heapq.heapify(heap)
+
+    # Lazy greedy: a popped score is only re-checked against what is covered now
+    covered = set()
+    chosen = []
+    total = 0
+    while heap and total < size:
+        neg, order, seg = heapq.heappop(heap)
+        s = score(seg, covered)
+        if s == 0:
+            continue
+        if heap and s < -heap[0][0]:
+            heapq.heappush(heap, (-s, order, seg))
+            continue
+        chosen.append(seg)
+        total += len(seg)
+        covered.update(seg[i:i + k] for i in range(len(seg) - k + 1))
+
+    return b''.join(reversed(chosen))[-size:]
+
+def build_dictionary(xml_file, multistream_index, namespaces, only_intro, encoding):
+    """Trains a dictionary on the first DICT_SAMPLE_BYTES of articles."""
+    samples = []
+    sampled = 0
+    source = open_source(xml_file, multistream_index)
+    try:
+        for title, raw_text, meta in iter_pages(source, namespaces):
+            data = prepare_article(raw_text, only_intro, encoding)
+            if data:
+                samples.append(data)
+                sampled += len(data)
+                if sampled >= DICT_SAMPLE_BYTES:
+                    break
+    finally:
+        source.close()
+    print(f"Training dictionary on {len(samples)} articles ({sampled} bytes)...")
+    return train_dictionary(samples)
+
+def iter_batches(pages, size):
+    batch = []
+    for page in pages:
+        batch.append(page)
+        if len(batch) == size:
+            yield batch
+            batch = []
+    if batch:
+        yield batch
+
+def iter_processed(pages, only_intro, encoding, jobs, zdict=None, codec='deflate', pool=None):
+    """Yields (title, compressed, meta) in input order, on one core or a process pool.
+
+    'pool' is a caller's Pool of 'jobs' workers to run on; without one, a
+    pool is opened for the duration of the generator.
+
+    Pages whose raw_text is None (reused in incremental mode) pass through
+    with compressed = None.
+
+    Results come back in submission order, so the output is byte-identical
+    whatever the number of jobs. At most jobs * PIPELINE_DEPTH batches are
+    in flight, which keeps the parser from running ahead of the workers.
+    """
+    if jobs <= 1:
+        for page in pages:
+            yield process_batch([page], only_intro, encoding, zdict, codec)[0]
+        return
+
+    if pool is None:
+        with multiprocessing.Pool(jobs) as pool:
+            yield from iter_processed(pages, only_intro, encoding, jobs, zdict, codec, pool)
+        return
+
+    pending = collections.deque()
+    for batch in iter_batches(pages, PIPELINE_BATCH):
+        pending.append(pool.apply_async(process_batch, (batch, only_intro, encoding, zdict, codec)))
+        if len(pending) >= jobs * PIPELINE_DEPTH:
+            yield from pending.popleft().get()
+    while pending:
+        yield from pending.popleft().get()
+
+def read_multistream_offsets(index_path):
+    """Stream start offsets from a *-multistream-index.txt[.bz2] file.
+
+    Each line is "offset:page_id:title"; many pages share one offset.
+    """
+    opener = bz2.open if index_path.endswith('.bz2') else open
+    offsets = set()
+    with opener(index_path, 'rt', encoding='utf-8') as f:
+        for line in f:
+            offset = line.split(':', 1)[0]
+            if offset:
+                offsets.add(int(offset))
+    return sorted(offsets)
+
+def decompress_range(task):
+    path, start, end = task
+    with open(path, 'rb') as f:
+        f.seek(start)
+        data = f.read(end - start)
+    # bz2.decompress handles several concatenated streams
+    return bz2.decompress(data)
+
+def iter_multistream_chunks(xml_file, index_file, pool=None, jobs=1):
+    """Yields the decompressed dump in order, decoding bz2 streams in parallel.
+
+    Runs on 'pool' (of 'jobs' workers), the same pool that cleans and
+    compresses the pages, or in this process without one. Never opens a
+    pool of its own: this generator is consumed while the cleaning pool
+    is running, and forking then would double the processes.
+    """
+    offsets = read_multistream_offsets(index_file)
+    # The index skips the header stream at 0 and the closing </mediawiki> stream
+    bounds = sorted(set([0] + offsets + [os.path.getsize(xml_file)]))
+    tasks = []
+    for i in range(0, len(bounds) - 1, MULTISTREAM_GROUP):
+        end = bounds[min(i + MULTISTREAM_GROUP, len(bounds) - 1)]
+        tasks.append((xml_file, bounds[i], end))
+    print(f"Multistream: {len(bounds) - 1} bz2 streams in {len(tasks)} tasks")
+
+    if pool is None:
+        for task in tasks:
+            yield decompress_range(task)
+        return
+
+    pending = collections.deque()
+    for task in tasks:
+        pending.append(pool.apply_async(decompress_range, (task,)))
+        if len(pending) >= jobs * PIPELINE_DEPTH:
+            yield pending.popleft().get()
+    while pending:
+        yield pending.popleft().get()
+
+class ChunkReader(io.RawIOBase):
+    """Read-only file object over an iterator of byte chunks (for iterparse)."""
+
+    def __init__(self, chunks):
+        self.chunks = iter(chunks)
+        self.chunk = memoryview(b'')
+
+    def readable(self):
+        return True
+
+    def readinto(self, b):
+        while not self.chunk:
+            try:
+                self.chunk = memoryview(next(self.chunks))
+            except StopIteration:
+                return 0
+        n = min(len(b), len(self.chunk))
+        b[:n] = self.chunk[:n]
+        self.chunk = self.chunk[n:]
+        return n
+
+def open_source(xml_file, multistream_index=None, pool=None, jobs=1):
+    if multistream_index:
+        return io.BufferedReader(ChunkReader(iter_multistream_chunks(xml_file, multistream_index, pool, jobs)),
+                                 buffer_size=1 << 20)
+    # Open input file (handle BZ2 or plain)
+    if xml_file.endswith('.bz2'):
+        return bz2.open(xml_file, 'rb')
+    return open(xml_file, 'rb')
+
+# Every shard gets a wiki.dat.NNN.blocks file with one SHA-1 per block,
+# used by sync_card.py to rewrite only the blocks that changed
+BLOCK_SIZE = 1024 * 1024
+BLOCKS_VERSION = 1
+
+class HashedShard:
+    """Data shard writer that hashes fixed-size blocks as it goes."""
+
+    def __init__(self, path, append=False):
+        self.path = path
+        self.hashes = []
+        self.block = hashlib.sha1()
+        self.block_fill = 0
+        self.size = 0
+        if append:
+            # Hash what is already there before appending to it
+            with open(path, "rb") as f:
+                for chunk in iter(lambda: f.read(BLOCK_SIZE), b''):
+                    self._hash(chunk)
+        self.f = open(path, "ab" if append else "wb")
+
+    def _hash(self, data):
+        view = memoryview(data)
+        while view:
+            n = min(len(view), BLOCK_SIZE - self.block_fill)
+            self.block.update(view[:n])
+            self.block_fill += n
+            self.size += n
+            view = view[n:]
+            if self.block_fill == BLOCK_SIZE:
+                self.hashes.append(self.block.hexdigest())
+                self.block = hashlib.sha1()
+                self.block_fill = 0
+
+    def write(self, data):
+        self.f.write(data)
+        self._hash(data)
+
+    def close(self):
+        self.f.close()
+        if self.block_fill:
+            self.hashes.append(self.block.hexdigest())
+        with open(self.path + ".blocks", "w", newline='\n') as f:
+            f.write(f"# wikiputer-blocks v{BLOCKS_VERSION} block_size={BLOCK_SIZE} size={self.size}\n")
+            for h in self.hashes:
+                f.write(h + "\n")
+
+MANIFEST_NAME = "wiki.manifest"
+MANIFEST_VERSION = 3
+
+def write_dictionary(output_dir, zdict):
+    """wiki.dict plus the wiki.dictid naming it."""
+    with open(os.path.join(output_dir, DICT_NAME), "wb") as f:
+        f.write(zdict)
+    with open(os.path.join(output_dir, DICT_ID_NAME), "w", newline='\n') as f:
+        f.write(f"{zlib.adler32(zdict):08x}\n")
+
+def manifest_settings(only_intro, encoding, zdict=None):
+    # Blobs can only be reused if they were built the same way
+    dict_id = f"{zlib.adler32(zdict):08x}" if zdict else "none"
+    return f"intro={int(only_intro)} encoding={encoding} dict={dict_id}"
+
+def load_manifest(build_dir, settings):
+    """Reads a previous build's manifest: key -> (rev_id, sha1, packed_offset, length)."""
+    path = os.path.join(build_dir, MANIFEST_NAME)
+    entries = {}
+    with open(path, encoding='utf-8') as f:
+        header = f.readline().rstrip('\n')
+        expected = f"# wikiputer-manifest v{MANIFEST_VERSION} {settings}"
+        if header != expected:
+            raise SystemExit(f"{path} was built with different settings ('{header}', need '{expected}')")
+        for line in f:
+            key, rev_id, sha1, offset, length = line.rstrip('\n').split('\t')
+            entries[key] = (rev_id, sha1, int(offset), int(length))
+    return entries
+
+def iter_incremental(pages, previous):
+    """Drops the text of pages unchanged since the previous build.
+
+    Yields (title, raw_text or None, meta + (reuse,)) where reuse is the
+    previous (packed_offset, length) for unchanged pages.
+    """
+    for title, raw_text, meta in pages:
+        key, rev_id, sha1 = meta
+        old = previous.get(key)
+        if old and ((rev_id and old[0] == rev_id) or old[1] == sha1):
+            yield title, None, meta + (old[2:],)
+        else:
+            yield title, raw_text, meta + (None,)
+
+class IndexSorter:
+    """Collects (title, offset, length) entries and returns them sorted by title.
+
+    Without a memory cap everything is sorted in a list, as before. With
+    one, sorted runs are spilled to temporary files whenever the estimated
+    size exceeds the cap and then k-way merged. Ties keep insertion order
+    in both modes, so the resulting index is byte-identical.
+    """
+    RUN_HEADER = struct.Struct('<H')
+    RUN_ENTRY = struct.Struct('<QI')
+
+    def __init__(self, mem_limit=None, tmp_dir=None):
+        self.mem_limit = mem_limit
+        self.tmp_dir = tmp_dir
+        self.entries = []
+        self.entries_size = 0
+        self.runs = []
+        self.total = 0
+
+    def add(self, title, offset, length):
+        self.entries.append((title, offset, length))
+        self.total += 1
+        if self.mem_limit:
+            self.entries_size += SORT_ENTRY_OVERHEAD + len(title)
+            if self.entries_size >= self.mem_limit:
+                self._spill()
+
+    def _spill(self):
+        self.entries.sort(key=lambda x: x[0])
+        run = tempfile.TemporaryFile(dir=self.tmp_dir)
+        self._write_run(run, self.entries)
+        self.runs.append(run)
+        print(f"Spilled sorted run {len(self.runs)} ({len(self.entries)} entries)")
+        self.entries = []
+        self.entries_size = 0
+
+    def _write_run(self, run, entries):
+        for title, offset, length in entries:
+            title_bytes = title.encode('utf-8')
+            run.write(self.RUN_HEADER.pack(len(title_bytes)))
+            run.write(title_bytes)
+            run.write(self.RUN_ENTRY.pack(offset, length))
+        run.flush()
+        run.seek(0)
+
+    def _read_run(self, run):
+        buffered = open(run.fileno(), 'rb', buffering=1 << 20, closefd=False)
+        while True:
+            header = buffered.read(self.RUN_HEADER.size)
+            if not header:
+                break
+            (title_len,) = self.RUN_HEADER.unpack(header)
+            title = buffered.read(title_len).decode('utf-8')
+            offset, length = self.RUN_ENTRY.unpack(buffered.read(self.RUN_ENTRY.size))
+            yield title, offset, length
+
+    def _merge(self, runs):
+        # heapq.merge breaks ties by iterable position, i.e. by run age
+        return heapq.merge(*(self._read_run(run) for run in runs), key=lambda x: x[0])
+
+    def sorted(self):
+        if not self.runs:
+            self.entries.sort(key=lambda x: x[0])
+            return iter(self.entries)
+
+        if self.entries:
+            self._spill()
+
+        # Too many runs to keep open at once: merge them in groups first
+        while len(self.runs) > SORT_MAX_FANIN:
+            merged = []
+            for i in range(0, len(self.runs), SORT_MAX_FANIN):
+                group = self.runs[i:i + SORT_MAX_FANIN]
+                run = tempfile.TemporaryFile(dir=self.tmp_dir)
+                self._write_run(run, self._merge(group))
+                for old in group:
+                    old.close()
+                merged.append(run)
+            self.runs = merged
+
+        return self._merge(self.runs)
+
+    def close(self):
+        for run in self.runs:
+            run.close()
+        self.runs = []
+        self.entries = []
+
+def convert_xml_dump(xml_file, output_dir, only_intro=False, encoding='utf8', jobs=1, sort_mem=None,
+                     multistream_index=None, namespaces=None, previous_dir=None, append=False,
+                     use_dict=False, dict_file=None, codec='deflate'):
     if not os.path.exists(output_dir):
         os.makedirs(output_dir)
+    if previous_dir and os.path.realpath(previous_dir) == os.path.realpath(output_dir):
+        raise SystemExit("--previous must be a different directory than --out")
+    if append and not previous_dir:
+        raise SystemExit("--append needs --previous")
 
     index_path = os.path.join(output_dir, "wiki.idx")
-    data_path = os.path.join(output_dir, "wiki.dat")
 
     print(f"Converting {xml_file}...")
     print(f"Mode: {'Only introductions' if only_intro else 'Full articles'}")
+    print(f"Encoding: {encoding}")
+    print(f"Jobs: {jobs}")
+    print(f"Codec: {codec}")
     
     articles_processed = 0
-    offset = 0
+    articles_reused = 0
     
-    index_entries = []
-
-    # Open input file (handle BZ2 or plain)
-    if xml_file.endswith('.bz2'):
-        source = bz2.open(xml_file, 'rb')
-    else:
-        source = open(xml_file, 'rb')
+    zdict = None
+    if dict_file:
+        with open(dict_file, "rb") as f:
+            zdict = f.read()[-DICT_SIZE:]
+    elif use_dict:
+        zdict = build_dictionary(xml_file, multistream_index, namespaces, only_intro, encoding)
+    if zdict:
+        write_dictionary(output_dir, zdict)
+        print(f"Preset dictionary: {len(zdict)} bytes ({DICT_NAME})")
+    
+    settings = manifest_settings(only_intro, encoding, zdict)
+    previous = None
+    previous_shards = {}
+    if previous_dir:
+        previous = load_manifest(previous_dir, settings)
+        print(f"Incremental: {len(previous)} articles in {previous_dir}")
+    
+    def read_previous_blob(packed_offset, length):
+        file_index, local_offset, blob_codec, size = unpack_offset(packed_offset)
+        f = previous_shards.get(file_index)
+        if f is None:
+            f = open(os.path.join(previous_dir, f"wiki.dat.{file_index:03d}"), "rb")
+            previous_shards[file_index] = f
+        f.seek(local_offset)
+        return blob_codec, f.read(length), size
+    
+    manifest = open(os.path.join(output_dir, MANIFEST_NAME), "w", encoding='utf-8', newline='\n')
+    manifest.write(f"# wikiputer-manifest v{MANIFEST_VERSION} {settings}\n")
+    
+    # Index entries; spilled to sorted runs in output_dir past sort_mem bytes
+    index_entries = IndexSorter(sort_mem, output_dir)
 
     # Configuration for file splitting
     MAX_FILE_SIZE = 2 * 1024 * 1024 * 1024 # 2GB limit to be safe for FAT32 and signed 32-bit seek
@@ -104,96 +952,117 @@ def convert_xml_dump(xml_file, output_dir, only_intro=False):
         if current_dat_file:
             current_dat_file.close()
         
+        if current_file_index > FILE_INDEX_MASK:
+            raise SystemExit(f"Too many data files (the index addresses {FILE_INDEX_MASK + 1})")
         filename = f"wiki.dat.{current_file_index:03d}"
         path = os.path.join(output_dir, filename)
-        current_dat_file = open(path, "wb")
+        current_dat_file = HashedShard(path)
         current_file_size = 0
         print(f"Started new data file: {filename}")
         current_file_index += 1
 
-    open_next_dat_file()
+    if append:
+        # Append-only layout: previous shards are kept byte for byte, unchanged
+        # articles keep their offsets and new blobs go after the last shard's end
+        shard_count = 0
+        while os.path.exists(os.path.join(previous_dir, f"wiki.dat.{shard_count:03d}")):
+            shutil.copyfile(os.path.join(previous_dir, f"wiki.dat.{shard_count:03d}"),
+                            os.path.join(output_dir, f"wiki.dat.{shard_count:03d}"))
+            shard_count += 1
+        if shard_count == 0:
+            raise SystemExit(f"No wiki.dat.* shards in {previous_dir}")
+        for i in range(shard_count - 1):
+            # Refresh block hashes of the untouched shards
+            HashedShard(os.path.join(output_dir, f"wiki.dat.{i:03d}"), append=True).close()
+        current_file_index = shard_count
+        last_path = os.path.join(output_dir, f"wiki.dat.{shard_count - 1:03d}")
+        current_dat_file = HashedShard(last_path, append=True)
+        current_file_size = current_dat_file.size
+        print(f"Appending to {os.path.basename(last_path)} at {current_file_size}")
+    else:
+        open_next_dat_file()
+
+    # One pool for bz2 decompression and for cleaning + compression, created
+    # before either generator starts so no fork happens with threads running
+    pool = multiprocessing.Pool(jobs) if jobs > 1 else None
+    source = open_source(xml_file, multistream_index, pool, jobs)
+
+    pages = iter_pages(source, namespaces)
+    if previous is not None:
+        pages = iter_incremental(pages, previous)
+    else:
+        pages = ((title, raw_text, meta + (None,)) for title, raw_text, meta in pages)
 
     try:
-        # Stream Parsing XML
-        context = ET.iterparse(source, events=("end",))
-        
-        title = None
-        
-        for event, elem in context:
-            tag = elem.tag.split('}')[-1] 
+        # Writer stage: consumes articles in dump order and assigns shard offsets
+        for title, compressed, meta in iter_processed(pages, only_intro, encoding, jobs, zdict, codec, pool):
+            key, rev_id, sha1, reuse = meta
+            if compressed is None and reuse and append:
+                # Unchanged and still in place in the copied shards
+                packed_offset, length = reuse
+                index_entries.add(title, packed_offset, length)
+                manifest.write(f"{key}\t{rev_id or ''}\t{sha1}\t{packed_offset}\t{length}\n")
+                articles_reused += 1
+                articles_processed += 1
+                continue
+            if compressed is None and reuse:
+                # Unchanged since the previous build: copy the blob as is
+                compressed = read_previous_blob(*reuse)
+                articles_reused += 1
+            if compressed is None:
+                continue
             
-            if tag == 'title':
-                title = elem.text
-            elif tag == 'text':
-                raw_text = elem.text
-                if title and raw_text:
-                    clean_text = clean_wiki_text(raw_text, only_intro)
-        
-                    if clean_text and len(clean_text) > MIN_ARTICLE_SIZE:
-                        # Compress
-                        compressed = zlib.compress(clean_text.encode('utf-8'))
-                        length = len(compressed)
-                        
-                        # Check file size limit
-                        if current_file_size + length > MAX_FILE_SIZE:
-                            open_next_dat_file()
-                            
-                        # Write
-                        current_dat_file.write(compressed)
-                        
-                        # Global offset logic? 
-                        # Option A: Index stores (FileIndex, LocalOffset) - Changes Index Format (12 bytes vs 8 bytes)
-                        # Option B: Index stores Global Offset. WikiEngine calculates FileIndex = Offset / MAX_FILE_SIZE.
-                        # Option B requires fixed file size chunks?
-                        # If we split exactly when full, files are variable size (close to MAX).
-                        # We cannot use Global Offset if sizes vary unless we track them.
-                        # Simplest: Index stores Global 64-bit offset.
-                        # BUT we must enforce PADDING to align to fixed boundary? 
-                        # Or: Just change Index to store File Index (2 bytes) + Local Offset (4 bytes)?
-                        # "offset" field in struct is 8 bytes (64 bit).
-                        # We can repack it: High 2 bytes = File Index, Low 6 bytes = Offset? 
-                        # Or specific bits.
-                        # Let's use: Offset field (64-bit) = (FileIndex << 32) | LocalOffset.
-                        # This works if LocalOffset < 4GB. MAX_FILE_SIZE = 2GB fits in 32 bits.
-                        # So GlobalOffset is logical.
-                        
-                        packed_offset = ((current_file_index - 1) << 32) | current_file_size
-                        
-                        # Store in index
-                        index_entries.append((title, packed_offset, length))
-                        
-                        current_file_size += length
-                        articles_processed += 1
-                        
-                        if articles_processed % 1000 == 0:
-                            print(f"Processed {articles_processed} articles...")
+            blob_codec, compressed, size = compressed
+            length = len(compressed)
+            
+            # Check file size limit
+            if current_file_size + length > MAX_FILE_SIZE:
+                open_next_dat_file()
+                
+            # Write
+            current_dat_file.write(compressed)
+            
+            # Offset field (64-bit) = (Size << 44) | (Codec << 40) | (FileIndex << 32) | LocalOffset.
+            # This works if LocalOffset < 4GB. MAX_FILE_SIZE = 2GB fits in 32 bits.
+            packed_offset = pack_offset(current_file_index - 1, current_file_size, blob_codec, size)
             
-            if tag == 'page':
-                elem.clear() # clear memory
+            # Store in index
+            index_entries.add(title, packed_offset, length)
+            manifest.write(f"{key}\t{rev_id or ''}\t{sha1}\t{packed_offset}\t{length}\n")
+            
+            current_file_size += length
+            articles_processed += 1
+            
+            if articles_processed % 1000 == 0:
+                print(f"Processed {articles_processed} articles...")
 
     finally:
         source.close()
+        if pool is not None:
+            pool.terminate()
+        manifest.close()
+        for f in previous_shards.values():
+            f.close()
         if current_dat_file:
             current_dat_file.close()
 
     print("Sorting index...")
-    index_entries.sort(key=lambda x: x[0])
+    sorted_entries = index_entries.sorted()
 
     print("Writing index...")
-    # Fixed record size: 64 bytes
-    RECORD_SIZE = 64
-    TITLE_LIMIT = 52
-
     with open(index_path, "wb") as f_idx:
-        for title, off, length in index_entries:
+        for title, off, length in sorted_entries:
             # Enforce title limit
             title_bytes = title.encode('utf-8')[:TITLE_LIMIT-1] 
             
-            packed = struct.pack(f'<{TITLE_LIMIT}sQI', title_bytes, off, length)
-            f_idx.write(packed)
+            f_idx.write(INDEX_RECORD.pack(title_bytes, off, length))
+    index_entries.close()
 
     print(f"Done! Processed {articles_processed} articles.")
+    if previous is not None:
+        print(f"Reused {articles_reused}, recompressed {articles_processed - articles_reused}.")
     print(f"Files created in {output_dir}")
+    report_memory()
 
 if __name__ == "__main__":
     parser = argparse.ArgumentParser(description="Convert MediaWiki XML dump to fast-search format")
@@ -201,6 +1070,32 @@ if __name__ == "__main__":
     parser.add_argument("--out", default="data", help="Output directory")
     parser.add_argument("--intro", action="store_true", 
                        help="Extract only introduction (first section) of each article")
+    parser.add_argument("--encoding", choices=["utf8", "compact"], default="utf8",
+                       help="Article text encoding. 'compact' stores one byte per letter for Cyrillic")
+    parser.add_argument("--jobs", type=int, default=os.cpu_count() or 1,
+                       help="Worker processes for cleaning/compression (1 = serial). Output is identical either way")
+    parser.add_argument("--sort-mem", type=int, default=0, metavar="MB",
+                       help="Memory cap for sorting the index; beyond it sorted runs are spilled to disk (0 = sort in memory)")
+    parser.add_argument("--multistream-index", metavar="PATH",
+                       help="*-multistream-index.txt[.bz2] for a multistream .xml.bz2; bz2 streams are then decoded in parallel")
+    parser.add_argument("--namespaces", metavar="NS[,NS...]",
+                       help="Only keep pages in these namespaces, e.g. '0' for articles only (default: all)")
+    parser.add_argument("--previous", metavar="DIR",
+                       help="Previous build (with its wiki.manifest). Unchanged articles are copied instead of recompressed")
+    parser.add_argument("--append", action="store_true",
+                       help="With --previous: keep the old shards as they are and append changed articles, "
+                            "so sync_card.py only has to copy the tail")
+    parser.add_argument("--dict", action="store_true",
+                       help="Train a 32 KB preset deflate dictionary on the corpus and compress every article with it")
+    parser.add_argument("--dict-file", metavar="PATH",
+                       help="Use an existing wiki.dict (e.g. the previous build's, for --previous)")
+    parser.add_argument("--codec", choices=["deflate", "lz4", "auto"], default="deflate",
+                       help="Article codec. 'lz4' decodes several times faster on the device but is larger; "
+                            "'auto' uses it for long articles when the size cost is small")
     args = parser.parse_args()
     
-    convert_xml_dump(args.input, args.out, args.intro)
\ No newline at end of file
+    sort_mem = args.sort_mem * 1024 * 1024 if args.sort_mem > 0 else None
+    namespaces = set(args.namespaces.split(',')) if args.namespaces else None
+    convert_xml_dump(args.input, args.out, args.intro, args.encoding, args.jobs, sort_mem,
+                     args.multistream_index, namespaces, args.previous, args.append,
+                     args.dict, args.dict_file, args.codec)
\ No newline at end of file
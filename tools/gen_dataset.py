@@ -0,0 +1,303 @@
+import argparse
+import bisect
+import math
+import os
+import random
+import struct
+from xml.sax.saxutils import escape
+
+import converter
+
+# Synthetic Wikipedia-like data for benchmarks: either a MediaWiki XML dump
+# for converter.py, or a ready card image (wiki.idx + wiki.dat.*) built
+# through the converter's own pipeline. Same seed, same output.
+
+LATIN_WORDS = """
+the of and in to was is for on as by with he at from his an were are which
+this be has had it or also first new their its after two one but not who
+they her she all been other more most used during time year years many some
+city river house music film album song game team school church party state
+history world war battle league club station island lake mountain county
+district village university college company system series album railway
+national international american british french german english european
+north south east west great old new saint royal general public early late
+john william james george charles henry thomas robert david richard paul
+london paris berlin york california texas england france germany china
+india japan italy spain canada australia russia africa europe america
+science physics biology chemistry mathematics computer language software
+""".split()
+
+CYRILLIC_WORDS = """
+и в не на с что по как из его к для от это был года за он до при также
+город река область район село деревня страна война история музыка фильм
+альбом песня игра команда школа церковь партия государство мир битва
+клуб станция остров озеро гора университет компания система серия дорога
+национальный российский советский русский московский американский
+северный южный восточный западный великий старый новый святой общий
+иван пётр александр николай сергей михаил владимир андрей дмитрий алексей
+москва петербург киев новгород казань волга урал сибирь кавказ россия
+наука физика биология химия математика язык литература искусство театр
+""".split()
+
+LATIN_QUALIFIERS = ["film", "album", "song", "band", "novel", "river", "disambiguation",
+                    "TV series", "footballer", "politician", "1999 film", "company", "ship"]
+CYRILLIC_QUALIFIERS = ["фильм", "альбом", "песня", "река", "значения", "роман",
+                       "футболист", "телесериал", "посёлок", "село"]
+
+# Article body size in bytes of wikitext: log-normal body plus a Pareto
+# tail, so a fraction of pages is larger than the device's 144 KB buffer
+SIZE_MEDIAN = 3500
+SIZE_SIGMA = 1.1
+TAIL_FRACTION = 0.004
+TAIL_MIN = 100 * 1024
+TAIL_ALPHA = 1.4
+SIZE_MAX = 900 * 1024
+
+# Card format limits, as in converter.py
+MAX_FILE_SIZE = 2 * 1024 * 1024 * 1024
+TITLE_LIMIT = 52
+
+# Head words are Zipf distributed so titles share prefixes like real ones
+ZIPF_S = 1.05
+
+def zipf_weights(n, s=ZIPF_S):
+    cum = []
+    total = 0.0
+    for rank in range(1, n + 1):
+        total += 1.0 / rank ** s
+        cum.append(total)
+    return cum
+
+class Language:
+    def __init__(self, words, qualifiers, list_of, battle_of):
+        self.words = words
+        self.qualifiers = qualifiers
+        self.list_of = list_of
+        self.battle_of = battle_of
+        self.cum = zipf_weights(len(words))
+
+    def word(self, rng):
+        return self.words[bisect.bisect_left(self.cum, rng.random() * self.cum[-1])]
+
+    def cap(self, w):
+        return w[:1].upper() + w[1:]
+
+LATIN = Language(LATIN_WORDS, LATIN_QUALIFIERS, "List of", "Battle of")
+CYRILLIC = Language(CYRILLIC_WORDS, CYRILLIC_QUALIFIERS, "Список", "Битва при")
+
+class Generator:
+    def __init__(self, seed, cyrillic, redirects):
+        self.rng = random.Random(seed)
+        self.cyrillic = cyrillic
+        self.redirects = redirects
+        self.seen = set()
+        self.titles = []  # Recent titles, redirect and link targets
+
+    def lang(self):
+        return CYRILLIC if self.rng.random() < self.cyrillic else LATIN
+
+    def title(self, lang):
+        rng = self.rng
+        # 1-5 words, mostly 1-3, then an occasional pattern around them
+        n = min(1 + int(rng.expovariate(0.5)), 5)
+        words = [lang.cap(lang.word(rng))] + [lang.word(rng) for _ in range(n - 1)]
+        t = " ".join(words)
+        r = rng.random()
+        if r < 0.06:
+            t = f"{lang.list_of} {words[0].lower()} {' '.join(words[1:])}".strip()
+        elif r < 0.10:
+            t = f"{lang.battle_of} {t}"
+        elif r < 0.22:
+            t = f"{t} ({rng.choice(lang.qualifiers)})"
+        elif r < 0.30:
+            t = f"{lang.cap(lang.word(rng))}, {t}"
+        return t
+
+    def unique_title(self, lang):
+        t = self.title(lang)
+        key = t
+        suffix = 2
+        while key in self.seen:
+            key = f"{t} ({suffix})"
+            suffix += 1
+        self.seen.add(key)
+        return key
+
+    def size(self):
+        rng = self.rng
+        if rng.random() < TAIL_FRACTION:
+            size = TAIL_MIN * (1 - rng.random()) ** (-1 / TAIL_ALPHA)
+        else:
+            size = rng.lognormvariate(math.log(SIZE_MEDIAN), SIZE_SIGMA)
+        return int(min(max(size, 200), SIZE_MAX))
+
+    def link(self, lang):
+        rng = self.rng
+        target = rng.choice(self.titles) if self.titles and rng.random() < 0.5 else self.title(lang)
+        if rng.random() < 0.3:
+            return f"[[{target}|{lang.word(rng)}]]"
+        return f"[[{target}]]"
+
+    def sentence(self, lang):
+        rng = self.rng
+        n = 6 + int(rng.expovariate(1 / 12))
+        parts = []
+        for _ in range(n):
+            r = rng.random()
+            if r < 0.10:
+                parts.append(self.link(lang))
+            elif r < 0.12:
+                parts.append(f"''{lang.word(rng)}''")
+            elif r < 0.14:
+                parts.append(str(rng.randint(1, 2024)))
+            else:
+                parts.append(lang.word(rng))
+        s = lang.cap(" ".join(parts)) + "."
+        r = rng.random()
+        if r < 0.25:
+            s += f'<ref name="r{rng.randint(1, 40)}">{{{{cite web |url=https://example.org/{rng.randint(1, 10**6)} |title={lang.cap(lang.word(rng))} |date={rng.randint(1990, 2024)}}}}}</ref>'
+        elif r < 0.30:
+            s += f'<ref name="r{rng.randint(1, 40)}" />'
+        elif r < 0.32:
+            s += f"<!-- {lang.word(rng)} {lang.word(rng)} -->"
+        return s
+
+    def infobox(self, lang, title):
+        rng = self.rng
+        fields = [f"| {lang.word(rng)} = {self.link(lang)}" for _ in range(rng.randint(4, 14))]
+        fields.append(f"| image = {{{{#if:{lang.word(rng)}|{lang.word(rng)}.jpg}}}}")
+        return "{{Infobox " + lang.word(rng) + f"\n| name = {title}\n" + "\n".join(fields) + "\n}}\n"
+
+    def table(self, lang):
+        rng = self.rng
+        cols = rng.randint(2, 5)
+        rows = [f'{{| class="wikitable"\n! ' + " !! ".join(lang.cap(lang.word(rng)) for _ in range(cols))]
+        for _ in range(rng.randint(2, 12)):
+            rows.append("|-\n| " + " || ".join(str(rng.randint(1, 9999)) for _ in range(cols)))
+        return "\n".join(rows) + "\n|}\n"
+
+    def article(self, lang, title):
+        rng = self.rng
+        target = self.size()
+        out = []
+        size = 0
+        if rng.random() < 0.6:
+            out.append(self.infobox(lang, title))
+        out.append(f"'''{title}''' " + self.sentence(lang) + "\n\n")
+        while size < target:
+            r = rng.random()
+            if r < 0.10:
+                level = "==" if rng.random() < 0.8 else "==="
+                block = f"\n{level} {lang.cap(lang.word(rng))} {lang.word(rng)} {level}\n"
+            elif r < 0.13:
+                block = self.table(lang)
+            elif r < 0.18:
+                block = "".join(f"* {self.sentence(lang)}\n" for _ in range(rng.randint(2, 8)))
+            elif r < 0.20:
+                block = f"[[File:{lang.cap(lang.word(rng))}.jpg|thumb|{self.sentence(lang)}]]\n"
+            else:
+                block = " ".join(self.sentence(lang) for _ in range(rng.randint(2, 7))) + "\n\n"
+            out.append(block)
+            size += len(block.encode('utf-8'))
+        out.append("\n== References ==\n{{reflist}}\n")
+        out.extend(f"[[Category:{lang.cap(lang.word(rng))} {lang.word(rng)}]]\n" for _ in range(rng.randint(1, 6)))
+        return "".join(out)
+
+    def pages(self, count):
+        """Yields (page_id, ns, title, text, redirect_target) for 'count' pages."""
+        rng = self.rng
+        for page_id in range(1, count + 1):
+            lang = self.lang()
+            title = self.unique_title(lang)
+            if self.titles and rng.random() < self.redirects:
+                yield page_id, 0, title, f"#REDIRECT [[{rng.choice(self.titles)}]]", True
+                continue
+            ns = 14 if rng.random() < 0.02 else 0
+            if ns == 14:
+                title = "Category:" + title
+            text = self.article(lang, title)
+            if len(self.titles) < 5000:
+                self.titles.append(title)
+            else:
+                self.titles[rng.randrange(5000)] = title
+            yield page_id, ns, title, text, False
+
+def write_xml(gen, count, path):
+    with open(path, "w", encoding="utf-8", newline="\n") as f:
+        f.write('<mediawiki xmlns="http://www.mediawiki.org/xml/export-0.10/" version="0.10">\n')
+        for page_id, ns, title, text, redirect in gen.pages(count):
+            f.write("  <page>\n")
+            f.write(f"    <title>{escape(title)}</title>\n")
+            f.write(f"    <ns>{ns}</ns>\n")
+            f.write(f"    <id>{page_id}</id>\n")
+            if redirect:
+                f.write(f'    <redirect title="{escape(text[12:-2], {chr(34): "&quot;"})}" />\n')
+            f.write("    <revision>\n")
+            f.write(f"      <id>{page_id * 10}</id>\n")
+            f.write(f'      <text xml:space="preserve">{escape(text)}</text>\n')
+            f.write("    </revision>\n")
+            f.write("  </page>\n")
+            if page_id % 10000 == 0:
+                print(f"Generated {page_id} pages...")
+        f.write("</mediawiki>\n")
+
+def write_card(gen, count, out_dir, encoding, codec, jobs):
+    """wiki.idx + wiki.dat.*, compressed by converter.process_page, skipping XML."""
+    os.makedirs(out_dir, exist_ok=True)
+
+    def pages():
+        for page_id, ns, title, text, redirect in gen.pages(count):
+            if redirect or ns != 0:
+                continue
+            yield title, text, (str(page_id), None, None, None)
+
+    index = converter.IndexSorter(None, out_dir)
+    shard = None
+    shard_index = -1
+    shard_size = MAX_FILE_SIZE
+    articles = 0
+    for title, result, meta in converter.iter_processed(pages(), False, encoding, jobs, None, codec):
+        if result is None:
+            continue
+        blob_codec, blob, size = result
+        if shard_size + len(blob) > MAX_FILE_SIZE:
+            if shard:
+                shard.close()
+            shard_index += 1
+            shard = open(os.path.join(out_dir, f"wiki.dat.{shard_index:03d}"), "wb")
+            shard_size = 0
+        shard.write(blob)
+        index.add(title, converter.pack_offset(shard_index, shard_size, blob_codec, size), len(blob))
+        shard_size += len(blob)
+        articles += 1
+        if articles % 10000 == 0:
+            print(f"Compressed {articles} articles...")
+    if shard:
+        shard.close()
+
+    with open(os.path.join(out_dir, "wiki.idx"), "wb") as f:
+        for title, off, length in index.sorted():
+            title_bytes = title.encode('utf-8')[:TITLE_LIMIT - 1]
+            f.write(struct.pack(f'<{TITLE_LIMIT}sQI', title_bytes, off, length))
+    index.close()
+    print(f"Wrote {articles} articles to {out_dir}")
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description="Generate a synthetic Wikipedia-like data set for benchmarks")
+    parser.add_argument("--pages", type=int, default=100000, help="Pages to generate (redirects included)")
+    parser.add_argument("--format", choices=["xml", "card"], default="xml",
+                        help="'xml': a MediaWiki dump for converter.py. 'card': wiki.idx + wiki.dat.* directly")
+    parser.add_argument("--out", required=True, help="Output file (xml) or directory (card)")
+    parser.add_argument("--seed", type=int, default=1, help="Random seed; the same seed gives the same data")
+    parser.add_argument("--cyrillic", type=float, default=0.5, help="Fraction of Cyrillic pages")
+    parser.add_argument("--redirects", type=float, default=0.1, help="Fraction of redirect pages")
+    parser.add_argument("--encoding", choices=["utf8", "compact"], default="utf8", help="Card format: text encoding")
+    parser.add_argument("--codec", choices=["deflate", "lz4", "auto"], default="deflate", help="Card format: codec")
+    parser.add_argument("--jobs", type=int, default=os.cpu_count() or 1, help="Card format: compression processes")
+    args = parser.parse_args()
+
+    gen = Generator(args.seed, args.cyrillic, args.redirects)
+    if args.format == "xml":
+        write_xml(gen, args.pages, args.out)
+    else:
+        write_card(gen, args.pages, args.out, args.encoding, args.codec, args.jobs)
@@ -0,0 +1,101 @@
+import re
+import os
+import argparse
+
+# Generates firmware/src/GlyphMap.h from the glyph table in Arial.h:
+# direct codepoint -> glyph index tables for the Latin and Cyrillic
+# blocks, so the renderer never has to search the font.
+
+GLYPH_RE = re.compile(
+    r'\{\s*(\d+),\s*(\d+),\s*(\d+),\s*(\d+),\s*(-?\d+),\s*(-?\d+)\s*\}'
+    r'.*//\s*0x([0-9A-Fa-f]+)\s+(\S+)')
+
+# Blocks that get a lookup table: (name, first codepoint, count)
+BLOCKS = [
+    ("LATIN", 0x00, 0x80),
+    ("CYRILLIC", 0x400, 0x100),
+]
+
+GLYPH_NONE = 0xFFFF
+
+def read_glyphs(font_path):
+    glyphs = []
+    in_table = False
+    with open(font_path, encoding='utf-8') as f:
+        for line in f:
+            if 'GFXglyph' in line and '[]' in line:
+                in_table = True
+                continue
+            if not in_table:
+                continue
+            m = GLYPH_RE.search(line)
+            if m:
+                yoff = int(m.group(6))
+                height = int(m.group(3))
+                cp = int(m.group(7), 16)
+                present = m.group(8) != '(skip)'
+                glyphs.append((cp, present, yoff, height))
+            if '};' in line:
+                break
+    return glyphs
+
+def format_table(values, per_line=12):
+    lines = []
+    for i in range(0, len(values), per_line):
+        chunk = values[i:i + per_line]
+        lines.append("    " + ", ".join(f"0x{v:04X}" for v in chunk) + ",")
+    return "\n".join(lines)
+
+def generate(font_path, out_path):
+    glyphs = read_glyphs(font_path)
+    if not glyphs:
+        raise SystemExit(f"No glyph table found in {font_path}")
+
+    index_of = {cp: i for i, (cp, present, _, _) in enumerate(glyphs) if present}
+
+    # Same ascent LovyanGFX derives for GFX fonts (it skips the last glyph)
+    baseline = max(-yoff for _, _, yoff, _ in glyphs[:-1])
+
+    out = []
+    out.append("// Generated by tools/gen_glyph_map.py from Arial.h - do not edit.")
+    out.append("#ifndef GLYPH_MAP_H")
+    out.append("#define GLYPH_MAP_H")
+    out.append("")
+    out.append("#include <stdint.h>")
+    out.append("")
+    out.append(f"#define GLYPH_NONE 0x{GLYPH_NONE:04X}")
+    out.append("// Distance from the top of a text line to the baseline")
+    out.append(f"#define GLYPH_BASELINE {baseline}")
+    out.append("")
+
+    for name, start, count in BLOCKS:
+        values = [index_of.get(cp, GLYPH_NONE) for cp in range(start, start + count)]
+        out.append(f"// U+{start:04X}..U+{start + count - 1:04X} -> index into Arial6pt16bGlyphs")
+        out.append(f"static constexpr uint16_t GLYPH_MAP_{name}[{count}] = {{")
+        out.append(format_table(values))
+        out.append("};")
+        out.append("")
+
+    out.append("constexpr uint16_t glyphIndexFor(uint32_t cp) {")
+    out.append("    return cp < 0x80 ? GLYPH_MAP_LATIN[cp]")
+    out.append("         : (cp >= 0x400 && cp < 0x500) ? GLYPH_MAP_CYRILLIC[cp - 0x400]")
+    out.append("         : GLYPH_NONE;")
+    out.append("}")
+    out.append("")
+    out.append("#endif")
+
+    with open(out_path, "w", encoding='utf-8', newline='\n') as f:
+        f.write("\n".join(out) + "\n")
+
+    print(f"Wrote {out_path} ({len(index_of)} glyphs, baseline {baseline})")
+
+if __name__ == "__main__":
+    here = os.path.dirname(os.path.abspath(__file__))
+    src = os.path.join(here, "..", "firmware", "src")
+
+    parser = argparse.ArgumentParser(description="Generate codepoint -> glyph lookup tables for Arial6pt16b")
+    parser.add_argument("--font", default=os.path.join(src, "Arial.h"), help="Font header to read")
+    parser.add_argument("--out", default=os.path.join(src, "GlyphMap.h"), help="Header to write")
+    args = parser.parse_args()
+
+    generate(args.font, args.out)
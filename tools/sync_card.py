@@ -0,0 +1,158 @@
+import os
+import sys
+import shutil
+import hashlib
+import argparse
+
+# Updates a card (or any copy of a build) from a new build by comparing the
+# per-shard block hash manifests (wiki.dat.NNN.blocks) written by converter.py.
+# Only blocks that differ are rewritten; appended tails and new shards are
+# copied; the index is always replaced.
+
+def read_blocks(path):
+    """Returns (block_size, size, [sha1...]) or None if missing/unreadable."""
+    try:
+        with open(path) as f:
+            header = f.readline().split()
+            fields = dict(item.split('=') for item in header[3:])
+            hashes = [line.strip() for line in f if line.strip()]
+        return int(fields['block_size']), int(fields['size']), hashes
+    except (OSError, KeyError, ValueError, IndexError):
+        return None
+
+def hash_file(path, block_size):
+    hashes = []
+    size = 0
+    with open(path, "rb") as f:
+        for chunk in iter(lambda: f.read(block_size), b''):
+            hashes.append(hashlib.sha1(chunk).hexdigest())
+            size += len(chunk)
+    return block_size, size, hashes
+
+def copy_atomic(src, dst):
+    tmp = dst + ".tmp"
+    shutil.copyfile(src, tmp)
+    os.replace(tmp, dst)
+
+def sync_shard(src, dst, verify, dry_run):
+    """Brings dst in line with src. Returns bytes written."""
+    src_blocks = read_blocks(src + ".blocks")
+    if src_blocks is None:
+        raise SystemExit(f"Missing {src}.blocks - rebuild with the current converter.py")
+    block_size, size, hashes = src_blocks
+
+    if not os.path.exists(dst):
+        print(f"  {os.path.basename(dst)}: new, copying {size} bytes")
+        if not dry_run:
+            shutil.copyfile(src, dst)
+            shutil.copyfile(src + ".blocks", dst + ".blocks")
+        return size
+
+    # The card's own manifest is trusted unless --verify; it is removed while
+    # the shard is being modified so an interrupted sync is never trusted
+    dst_blocks = None if verify else read_blocks(dst + ".blocks")
+    if dst_blocks is None or dst_blocks[0] != block_size:
+        print(f"  {os.path.basename(dst)}: hashing card copy...")
+        dst_blocks = hash_file(dst, block_size)
+    _, dst_size, dst_hashes = dst_blocks
+
+    changed = [i for i, h in enumerate(hashes) if i >= len(dst_hashes) or dst_hashes[i] != h]
+    # A shrunk shard can leave a short last block that still hashes the same
+    if dst_size != size and hashes and (len(hashes) - 1) not in changed:
+        changed.append(len(hashes) - 1)
+
+    if not changed and dst_size == size:
+        print(f"  {os.path.basename(dst)}: unchanged")
+        if not dry_run and not os.path.exists(dst + ".blocks"):
+            shutil.copyfile(src + ".blocks", dst + ".blocks")
+        return 0
+
+    written = 0
+    if not dry_run:
+        if os.path.exists(dst + ".blocks"):
+            os.remove(dst + ".blocks")
+        with open(src, "rb") as fin, open(dst, "r+b") as fout:
+            for i in changed:
+                fin.seek(i * block_size)
+                data = fin.read(block_size)
+                fout.seek(i * block_size)
+                fout.write(data)
+                written += len(data)
+            fout.truncate(size)
+        shutil.copyfile(src + ".blocks", dst + ".blocks")
+    else:
+        written = sum(min(block_size, size - i * block_size) for i in changed)
+
+    print(f"  {os.path.basename(dst)}: {len(changed)}/{len(hashes)} blocks rewritten ({written} bytes)")
+    return written
+
+def sync(build_dir, card_dir, verify=False, dry_run=False):
+    total_written = 0
+    total_size = 0
+
+    index = 0
+    while os.path.exists(os.path.join(build_dir, f"wiki.dat.{index:03d}")):
+        name = f"wiki.dat.{index:03d}"
+        src = os.path.join(build_dir, name)
+        total_size += os.path.getsize(src)
+        total_written += sync_shard(src, os.path.join(card_dir, name), verify, dry_run)
+        index += 1
+
+    if index == 0:
+        raise SystemExit(f"No wiki.dat.* shards in {build_dir}")
+
+    # Shards the new build no longer has
+    stale = index
+    while os.path.exists(os.path.join(card_dir, f"wiki.dat.{stale:03d}")):
+        name = f"wiki.dat.{stale:03d}"
+        print(f"  {name}: removed")
+        if not dry_run:
+            os.remove(os.path.join(card_dir, name))
+            if os.path.exists(os.path.join(card_dir, name + ".blocks")):
+                os.remove(os.path.join(card_dir, name + ".blocks"))
+        stale += 1
+
+    # Preset dictionary (converter.py --dict) and its id, before the index
+    # that needs them
+    for name in ("wiki.dict", "wiki.dictid"):
+        dict_path = os.path.join(build_dir, name)
+        if not os.path.exists(dict_path):
+            continue
+        card_dict = os.path.join(card_dir, name)
+        with open(dict_path, "rb") as f:
+            new_dict = f.read()
+        old_dict = None
+        if os.path.exists(card_dict):
+            with open(card_dict, "rb") as f:
+                old_dict = f.read()
+        if old_dict != new_dict:
+            print(f"  {name}: copying {len(new_dict)} bytes")
+            if not dry_run:
+                copy_atomic(dict_path, card_dict)
+            total_written += len(new_dict)
+        total_size += len(new_dict)
+
+    # Index last, so the card never points at data that is not there yet
+    idx_size = os.path.getsize(os.path.join(build_dir, "wiki.idx"))
+    print(f"  wiki.idx: copying {idx_size} bytes")
+    if not dry_run:
+        copy_atomic(os.path.join(build_dir, "wiki.idx"), os.path.join(card_dir, "wiki.idx"))
+    total_written += idx_size
+    total_size += idx_size
+
+    print(f"Done! Wrote {total_written} of {total_size} bytes ({100.0 * total_written / max(total_size, 1):.1f}%)")
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description="Update an SD card from a new build, rewriting only changed blocks")
+    parser.add_argument("build", help="Build directory (converter.py --out)")
+    parser.add_argument("card", help="Card root (or directory) holding wiki.idx and wiki.dat.*")
+    parser.add_argument("--verify", action="store_true",
+                        help="Hash the card's shards instead of trusting its .blocks files")
+    parser.add_argument("--dry-run", action="store_true", help="Only report what would be written")
+    args = parser.parse_args()
+
+    if not os.path.isdir(args.card):
+        print(f"Error: {args.card} is not a directory")
+        sys.exit(1)
+
+    sync(args.build, args.card, args.verify, args.dry_run)
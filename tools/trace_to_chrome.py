@@ -0,0 +1,86 @@
+import argparse
+import json
+import sys
+
+# Converts a trace dump from the firmware (built with -DWIKI_TRACE, dumped
+# by sending 't' over serial, see firmware/src/Trace.h) into Chrome trace
+# JSON for chrome://tracing or ui.perfetto.dev. Each core is a process,
+# each FreeRTOS task a thread in it. Other serial output is skipped.
+
+WRAP = 1 << 32  # micros() is 32 bits on the device
+
+def read_dumps(lines):
+    """Returns every dump in the capture as (now_us, [event tuples])."""
+    dumps = []
+    current = None
+    for line in lines:
+        line = line.strip()
+        if line.startswith("# trace begin"):
+            current = (int(line.split()[3]), [])
+        elif line.startswith("# trace end"):
+            if current is not None:
+                dumps.append(current)
+            current = None
+        elif current is not None:
+            parts = line.split(" ", 4)
+            if len(parts) < 5:
+                continue  # Interleaved log output or a torn line
+            try:
+                core, start, dur = int(parts[0]), int(parts[1]), int(parts[2])
+            except ValueError:
+                continue
+            current[1].append((core, start, dur, parts[3], parts[4]))
+    return dumps
+
+def to_chrome(now_us, events):
+    # Place events relative to the dump so a micros() wrap in between is harmless
+    def age(start):
+        delta = (now_us - start) % WRAP
+        return -delta
+
+    base = min((age(e[1]) for e in events), default=0)
+    tids = {}
+    out = []
+    for core, start, dur, task, name in events:
+        tid = tids.setdefault(task, len(tids) + 1)
+        out.append({
+            "name": name,
+            "ph": "X",
+            "ts": age(start) - base,
+            "dur": dur,
+            "pid": core,
+            "tid": tid,
+        })
+
+    cores = sorted({e[0] for e in events})
+    for core in cores:
+        out.append({"name": "process_name", "ph": "M", "pid": core, "args": {"name": f"core {core}"}})
+        for task, tid in tids.items():
+            out.append({"name": "thread_name", "ph": "M", "pid": core, "tid": tid, "args": {"name": task}})
+    out.sort(key=lambda e: (e["ph"] != "M", e.get("ts", 0)))
+    return {"traceEvents": out, "displayTimeUnit": "ms"}
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description="Convert a WIKI_TRACE serial dump to Chrome trace JSON")
+    parser.add_argument("capture", nargs="?", help="Serial log containing the dump (default: stdin)")
+    parser.add_argument("-o", "--out", help="Output JSON file (default: stdout)")
+    parser.add_argument("--dump", type=int, default=-1, help="Which dump of the capture to convert (default: the last)")
+    args = parser.parse_args()
+
+    if args.capture:
+        with open(args.capture, "r", encoding="utf-8", errors="replace") as f:
+            dumps = read_dumps(f)
+    else:
+        dumps = read_dumps(sys.stdin)
+    if not dumps:
+        sys.exit("No '# trace begin' ... '# trace end' block found")
+
+    now_us, events = dumps[args.dump]
+    trace = to_chrome(now_us, events)
+    print(f"{len(events)} events from dump {args.dump % len(dumps) + 1} of {len(dumps)}", file=sys.stderr)
+
+    if args.out:
+        with open(args.out, "w") as f:
+            json.dump(trace, f)
+    else:
+        json.dump(trace, sys.stdout)
@@ -32,8 +32,8 @@ def trim_index(index_path, max_dat_index, output_path):
                 # But we only need offset at 52
                 offset = struct.unpack_from("<Q", chunk, 52)[0]
                 
-                # Decode file index (High 32 bits)
-                file_index = (offset >> 32) & 0xFFFFFFFF
+                # Decode file index (bits 32-39; the codec id sits above it)
+                file_index = (offset >> 32) & 0xFF
                 
                 if file_index <= max_dat_index:
                     f_out.write(chunk)